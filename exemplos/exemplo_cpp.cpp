@@ -0,0 +1,92 @@
+/**
+ * @file exemplo_cpp.cpp
+ * @brief Exemplo do uso do coletor de lixo a partir de C++.
+ *
+ * Este exemplo constroi uma arvore binaria com gc_make, liga os nos com
+ * campos gc_ptr declarados com GC_CAMPOS e mostra que as raizes RAII sao
+ * removidas automaticamente no fim do seu ambito.
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#include "../src/gc.hpp"
+#include <cstdio>
+
+/**
+ * @brief No de uma arvore binaria gerida pelo coletor.
+ */
+struct No {
+  int valor;
+  gc_ptr<No> esquerdo;
+  gc_ptr<No> direito;
+
+  explicit No(int v) : valor(v) {}
+};
+
+GC_CAMPOS(No, &No::esquerdo, &No::direito);
+
+/**
+ * @brief Constroi uma arvore completa com a profundidade indicada.
+ */
+static gc_root<No> construir(gc_t *gc, int profundidade, int &contador) {
+  gc_root<No> no = gc_make<No>(gc, contador++);
+  if (profundidade > 0) {
+    // Os filhos ficam vivos atraves dos campos, sem raizes proprias
+    no->esquerdo = construir(gc, profundidade - 1, contador);
+    no->direito = construir(gc, profundidade - 1, contador);
+  }
+  return no;
+}
+
+/**
+ * @brief Soma os valores de todos os nos da arvore.
+ */
+static long somar(gc_ptr<No> no) {
+  return no ? no->valor + somar(no->esquerdo) + somar(no->direito) : 0;
+}
+
+/**
+ * @brief Mostra o numero de objetos vivos no coletor.
+ */
+static void mostrar(gc_t *gc, const char *momento) {
+  size_t total_alocado, total_livre, num_objetos;
+  gc_estatisticas(gc, &total_alocado, &total_livre, &num_objetos);
+  std::printf("%s: %zu objetos, %zu bytes\n", momento, num_objetos,
+              total_alocado);
+}
+
+/**
+ * @brief Ponto de entrada do programa.
+ */
+int main() {
+  gc_t *gc = gc_inicializar(1024 * 1024);
+  if (!gc) {
+    std::fprintf(stderr, "Erro ao inicializar o coletor de lixo.\n");
+    return 1;
+  }
+
+  std::printf("Exemplo C++ de Coletor de Lixo\n");
+
+  {
+    int contador = 0;
+    gc_root<No> raiz = construir(gc, 6, contador);
+
+    gc_coletar(gc);
+    mostrar(gc, "Arvore com raiz");
+    std::printf("Soma dos valores: %ld\n", somar(raiz));
+
+    // Cortar uma subarvore: deixa de ser alcançavel
+    raiz->esquerdo = nullptr;
+    gc_coletar(gc);
+    mostrar(gc, "Sem a subarvore esquerda");
+  }
+
+  // A raiz foi removida no fim do ambito
+  gc_coletar(gc);
+  mostrar(gc, "Depois do ambito");
+
+  gc_finalizar(gc);
+
+  return 0;
+}
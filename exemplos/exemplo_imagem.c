@@ -0,0 +1,116 @@
+/**
+ * @file exemplo_imagem.c
+ * @brief Exemplo de gravaçao e carregamento de uma imagem do heap.
+ *
+ * Com "gravar" cria uma lista de pessoas e grava-a numa imagem; com
+ * "carregar" carrega a imagem num processo novo (a imagem e entao a
+ * primeira memoria do pool), aloca um objeto e coleta, verificando que
+ * os objetos da imagem continuam no coletor. Deve correr nos dois modos
+ * de compilaçao (make e make COMPRIMIDO=1).
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#include "../src/gc.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief Numero de pessoas gravadas na imagem.
+ */
+#define NUM_PESSOAS 3
+
+/**
+ * @brief Estrutura de dados de exemplo para teste.
+ */
+typedef struct Pessoa {
+  int id;
+  int idade;
+} pessoa_t;
+
+/**
+ * @brief Cria as pessoas e grava o heap na imagem.
+ *
+ * @param caminho Caminho do ficheiro de imagem.
+ * @return 0 em caso de sucesso, 1 em caso de erro.
+ */
+static int gravar(const char *caminho) {
+  gc_t *gc = gc_inicializar(1024 * 1024);
+  if (!gc) {
+    fprintf(stderr, "Erro ao inicializar o coletor de lixo.\n");
+    return 1;
+  }
+
+  for (int i = 0; i < NUM_PESSOAS; i++) {
+    pessoa_t *p = (pessoa_t *)gc_alocar(gc, sizeof(pessoa_t));
+    p->id = i + 1;
+    p->idade = 20 + i;
+    gc_registar_raiz(gc, p);
+  }
+
+  int resultado = gc_salvar_imagem(gc, caminho);
+  gc_finalizar(gc);
+  if (resultado != 0) {
+    fprintf(stderr, "Erro ao gravar a imagem (%d).\n", resultado);
+    return 1;
+  }
+
+  printf("Imagem gravada com %d pessoas em %s\n", NUM_PESSOAS, caminho);
+  return 0;
+}
+
+/**
+ * @brief Carrega a imagem, aloca um objeto e coleta.
+ *
+ * @param caminho Caminho do ficheiro de imagem.
+ * @return 0 se os objetos da imagem sobreviverem, 1 caso contrario.
+ */
+static int carregar(const char *caminho) {
+  gc_t *gc = gc_carregar_imagem(caminho);
+  if (!gc) {
+    fprintf(stderr, "Erro ao carregar a imagem.\n");
+    return 1;
+  }
+
+  size_t total_alocado, total_livre, num_objetos;
+  gc_estatisticas(gc, &total_alocado, &total_livre, &num_objetos);
+  printf("Imagem carregada: %zu objetos, %zu bytes\n", num_objetos,
+         total_alocado);
+  size_t objetos_imagem = num_objetos;
+  size_t memoria_imagem = total_alocado;
+
+  // A primeira alocaçao liga-se a lista de objetos a frente da imagem
+  char *nome = (char *)gc_alocar(gc, 20);
+  snprintf(nome, 20, "Zacarias");
+  gc_estatisticas(gc, &total_alocado, &total_livre, &num_objetos);
+  printf("Apos alocar: %zu objetos\n", num_objetos);
+  int erro = num_objetos != objetos_imagem + 1;
+
+  // O objeto novo nao tem raiz; os da imagem tem
+  gc_coletar(gc);
+  gc_estatisticas(gc, &total_alocado, &total_livre, &num_objetos);
+  printf("Apos a coleta: %zu objetos, %zu bytes\n", num_objetos,
+         total_alocado);
+  erro |= num_objetos != objetos_imagem || total_alocado != memoria_imagem;
+
+  gc_finalizar(gc);
+
+  printf(erro ? "Objetos da imagem perdidos!\n" : "Imagem intacta.\n");
+  return erro;
+}
+
+/**
+ * @brief Ponto de entrada do programa.
+ */
+int main(int argc, char **argv) {
+  if (argc == 3 && strcmp(argv[1], "gravar") == 0) {
+    return gravar(argv[2]);
+  }
+  if (argc == 3 && strcmp(argv[1], "carregar") == 0) {
+    return carregar(argv[2]);
+  }
+
+  fprintf(stderr, "Uso: %s gravar|carregar <imagem>\n", argv[0]);
+  return 1;
+}
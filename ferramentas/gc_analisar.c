@@ -0,0 +1,415 @@
+/**
+ * @file gc_analisar.c
+ * @brief Analisador offline de snapshots do coletor de lixo.
+ *
+ * Esta ferramenta mapeia em memoria um ficheiro escrito por gc_snapshot,
+ * calcula a arvore de dominadores do grafo de objetos (algoritmo de
+ * Lengauer-Tarjan) e o tamanho retido por cada objeto, isto e, a memoria
+ * que seria libertada se esse objeto deixasse de ser alcançavel.
+ *
+ * Uso: gc_analisar <snapshot> [num_objetos_a_listar]
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../src/gc_formato.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Valor usado para indicar ausencia de vertice.
+ */
+#define NENHUM UINT32_MAX
+
+/**
+ * @brief Grafo em formato CSR (compressed sparse row).
+ *
+ * @param inicio Indice da primeira aresta de cada vertice (n + 1 entradas).
+ * @param destino Vertice de destino de cada aresta.
+ */
+typedef struct Grafo {
+  uint32_t *inicio;
+  uint32_t *destino;
+} grafo_t;
+
+/**
+ * @brief Constroi um grafo CSR a partir de uma lista de arestas.
+ *
+ * O vertice raiz virtual (indice n - 1) tem uma aresta para cada raiz.
+ *
+ * @param grafo Grafo a preencher.
+ * @param n Numero de vertices, incluindo a raiz virtual.
+ * @param raizes Ids das raizes.
+ * @param num_raizes Numero de raizes.
+ * @param arestas Pares (de, para).
+ * @param num_arestas Numero de pares.
+ * @param inverter Se diferente de zero, constroi o grafo de predecessores.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+static int grafo_construir(grafo_t *grafo, uint32_t n, const uint32_t *raizes,
+                           uint64_t num_raizes, const uint32_t *arestas,
+                           uint64_t num_arestas, int inverter) {
+  uint32_t virtual = n - 1;
+  uint64_t total = num_raizes + num_arestas;
+
+  grafo->inicio = (uint32_t *)calloc((size_t)n + 1, sizeof(uint32_t));
+  grafo->destino = (uint32_t *)malloc((total ? total : 1) * sizeof(uint32_t));
+  if (!grafo->inicio || !grafo->destino) {
+    return -1;
+  }
+
+  // Contar arestas por vertice de origem
+  for (uint64_t i = 0; i < num_raizes; i++) {
+    grafo->inicio[(inverter ? raizes[i] : virtual) + 1]++;
+  }
+  for (uint64_t i = 0; i < num_arestas; i++) {
+    grafo->inicio[arestas[2 * i + (inverter ? 1 : 0)] + 1]++;
+  }
+  for (uint32_t v = 0; v < n; v++) {
+    grafo->inicio[v + 1] += grafo->inicio[v];
+  }
+
+  // Distribuir as arestas (usa um cursor temporario por vertice)
+  uint32_t *cursor = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  if (!cursor) {
+    return -1;
+  }
+  for (uint32_t v = 0; v < n; v++) {
+    cursor[v] = grafo->inicio[v];
+  }
+  for (uint64_t i = 0; i < num_raizes; i++) {
+    uint32_t de = inverter ? raizes[i] : virtual;
+    grafo->destino[cursor[de]++] = inverter ? virtual : raizes[i];
+  }
+  for (uint64_t i = 0; i < num_arestas; i++) {
+    uint32_t de = arestas[2 * i + (inverter ? 1 : 0)];
+    grafo->destino[cursor[de]++] = arestas[2 * i + (inverter ? 0 : 1)];
+  }
+  free(cursor);
+
+  return 0;
+}
+
+/**
+ * @brief Avalia um vertice na floresta do Lengauer-Tarjan, com compressao
+ * de caminho iterativa.
+ *
+ * @param v Vertice a avaliar.
+ * @param ancestral Ancestral de cada vertice na floresta.
+ * @param rotulo Vertice com menor semi-dominador no caminho.
+ * @param semi Numero de semi-dominador (em ordem DFS) de cada vertice.
+ * @param pilha Espaço auxiliar com n entradas.
+ * @return Vertice com menor semi-dominador entre v e a raiz da sua arvore.
+ */
+static uint32_t avaliar(uint32_t v, uint32_t *ancestral, uint32_t *rotulo,
+                        const uint32_t *semi, uint32_t *pilha) {
+  if (ancestral[v] == NENHUM) {
+    return v;
+  }
+
+  // Recolher o caminho ate ao vertice cujo ancestral e a raiz da arvore
+  size_t topo = 0;
+  uint32_t u = v;
+  while (ancestral[ancestral[u]] != NENHUM) {
+    pilha[topo++] = u;
+    u = ancestral[u];
+  }
+
+  // Comprimir do topo para baixo
+  while (topo > 0) {
+    uint32_t w = pilha[--topo];
+    uint32_t a = ancestral[w];
+    if (semi[rotulo[a]] < semi[rotulo[w]]) {
+      rotulo[w] = rotulo[a];
+    }
+    ancestral[w] = ancestral[a];
+  }
+
+  return rotulo[v];
+}
+
+/**
+ * @brief Ponto de entrada da ferramenta.
+ */
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Uso: %s <snapshot> [num_objetos_a_listar]\n", argv[0]);
+    return 1;
+  }
+  size_t listar = argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 20;
+
+  // Mapear o ficheiro em memoria
+  int fd = open(argv[1], O_RDONLY);
+  if (fd < 0) {
+    perror("open");
+    return 1;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      (size_t)info.st_size < sizeof(gc_snapshot_cabecalho_t)) {
+    fprintf(stderr, "Ficheiro invalido.\n");
+    close(fd);
+    return 1;
+  }
+  size_t tamanho_ficheiro = (size_t)info.st_size;
+  const uint8_t *mapa = (const uint8_t *)mmap(NULL, tamanho_ficheiro, PROT_READ,
+                                              MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapa == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+
+  // Validar o cabecalho
+  const gc_snapshot_cabecalho_t *cab = (const gc_snapshot_cabecalho_t *)mapa;
+  uint64_t esperado = sizeof(*cab) +
+                      cab->num_objetos * sizeof(gc_snapshot_objeto_t) +
+                      cab->num_raizes * sizeof(uint32_t) +
+                      cab->num_referencias * 2 * sizeof(uint32_t);
+  if (cab->magia != GC_SNAPSHOT_MAGIA || cab->versao != GC_SNAPSHOT_VERSAO ||
+      cab->num_objetos >= UINT32_MAX || esperado != tamanho_ficheiro) {
+    fprintf(stderr, "Ficheiro de snapshot invalido ou corrompido.\n");
+    munmap((void *)mapa, tamanho_ficheiro);
+    return 1;
+  }
+
+  const gc_snapshot_objeto_t *objetos =
+      (const gc_snapshot_objeto_t *)(mapa + sizeof(*cab));
+  const uint32_t *raizes = (const uint32_t *)(objetos + cab->num_objetos);
+  const uint32_t *arestas = raizes + cab->num_raizes;
+
+  // Validar ids
+  for (uint64_t i = 0; i < cab->num_raizes; i++) {
+    if (raizes[i] >= cab->num_objetos) {
+      fprintf(stderr, "Raiz %llu com id invalido.\n", (unsigned long long)i);
+      munmap((void *)mapa, tamanho_ficheiro);
+      return 1;
+    }
+  }
+  for (uint64_t i = 0; i < 2 * cab->num_referencias; i++) {
+    if (arestas[i] >= cab->num_objetos) {
+      fprintf(stderr, "Referencia %llu com id invalido.\n",
+              (unsigned long long)(i / 2));
+      munmap((void *)mapa, tamanho_ficheiro);
+      return 1;
+    }
+  }
+
+  // Vertices 0..n-2 sao objetos, n-1 e a raiz virtual
+  uint32_t n = (uint32_t)cab->num_objetos + 1;
+  uint32_t virtual = n - 1;
+
+  grafo_t sucessores, predecessores;
+  uint32_t *dfs = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  uint32_t *vertice = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  uint32_t *pai = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  uint32_t *semi = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  uint32_t *idom = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  uint32_t *ancestral = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  uint32_t *rotulo = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  uint32_t *balde = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  uint32_t *proximo_balde = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  uint32_t *pilha = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  uint32_t *aresta_atual = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  uint64_t *retido = (uint64_t *)malloc((size_t)n * sizeof(uint64_t));
+  if (!dfs || !vertice || !pai || !semi || !idom || !ancestral || !rotulo ||
+      !balde || !proximo_balde || !pilha || !aresta_atual || !retido ||
+      grafo_construir(&sucessores, n, raizes, cab->num_raizes, arestas,
+                      cab->num_referencias, 0) != 0 ||
+      grafo_construir(&predecessores, n, raizes, cab->num_raizes, arestas,
+                      cab->num_referencias, 1) != 0) {
+    fprintf(stderr, "Memoria insuficiente.\n");
+    return 1;
+  }
+
+  for (uint32_t v = 0; v < n; v++) {
+    dfs[v] = NENHUM;
+    ancestral[v] = NENHUM;
+    rotulo[v] = v;
+    balde[v] = NENHUM;
+    idom[v] = NENHUM;
+  }
+
+  // DFS iterativa a partir da raiz virtual, numerando os vertices
+  uint32_t num_alcancaveis = 0;
+  size_t topo = 0;
+  dfs[virtual] = num_alcancaveis;
+  semi[virtual] = num_alcancaveis;
+  vertice[num_alcancaveis++] = virtual;
+  pai[virtual] = NENHUM;
+  aresta_atual[virtual] = sucessores.inicio[virtual];
+  pilha[topo++] = virtual;
+  while (topo > 0) {
+    uint32_t v = pilha[topo - 1];
+    if (aresta_atual[v] == sucessores.inicio[v + 1]) {
+      topo--;
+      continue;
+    }
+    uint32_t w = sucessores.destino[aresta_atual[v]++];
+    if (dfs[w] == NENHUM) {
+      dfs[w] = num_alcancaveis;
+      semi[w] = num_alcancaveis;
+      vertice[num_alcancaveis++] = w;
+      pai[w] = v;
+      aresta_atual[w] = sucessores.inicio[w];
+      pilha[topo++] = w;
+    }
+  }
+
+  // Lengauer-Tarjan: semi-dominadores e dominadores implicitos
+  for (uint32_t i = num_alcancaveis - 1; i >= 1; i--) {
+    uint32_t w = vertice[i];
+    for (uint32_t e = predecessores.inicio[w]; e < predecessores.inicio[w + 1];
+         e++) {
+      uint32_t v = predecessores.destino[e];
+      if (dfs[v] == NENHUM) {
+        continue; // Predecessor inalcançavel
+      }
+      uint32_t u = avaliar(v, ancestral, rotulo, semi, pilha);
+      if (semi[u] < semi[w]) {
+        semi[w] = semi[u];
+      }
+    }
+    uint32_t s = vertice[semi[w]];
+    proximo_balde[w] = balde[s];
+    balde[s] = w;
+    ancestral[w] = pai[w];
+
+    for (uint32_t v = balde[pai[w]]; v != NENHUM; v = proximo_balde[v]) {
+      uint32_t u = avaliar(v, ancestral, rotulo, semi, pilha);
+      idom[v] = semi[u] < semi[v] ? u : pai[w];
+    }
+    balde[pai[w]] = NENHUM;
+  }
+  for (uint32_t i = 1; i < num_alcancaveis; i++) {
+    uint32_t w = vertice[i];
+    if (idom[w] != vertice[semi[w]]) {
+      idom[w] = idom[idom[w]];
+    }
+  }
+
+  // Tamanhos retidos: acumular em ordem DFS inversa
+  uint64_t total_alcancavel = 0, total_heap = 0;
+  for (uint32_t v = 0; v < n; v++) {
+    retido[v] = v == virtual ? 0 : objetos[v].tamanho;
+    total_heap += retido[v];
+  }
+  for (uint32_t i = num_alcancaveis - 1; i >= 1; i--) {
+    uint32_t w = vertice[i];
+    retido[idom[w]] += retido[w];
+  }
+  total_alcancavel = retido[virtual];
+
+  printf("Objetos: %llu (%llu bytes)\n", (unsigned long long)cab->num_objetos,
+         (unsigned long long)total_heap);
+  printf("Raizes: %llu, referencias: %llu\n",
+         (unsigned long long)cab->num_raizes,
+         (unsigned long long)cab->num_referencias);
+  printf("Alcancaveis: %u (%llu bytes), lixo: %llu bytes\n",
+         num_alcancaveis - 1, (unsigned long long)total_alcancavel,
+         (unsigned long long)(total_heap - total_alcancavel));
+
+  // Selecionar os maiores tamanhos retidos com um min-heap de tamanho fixo
+  if (listar > num_alcancaveis - 1) {
+    listar = num_alcancaveis - 1;
+  }
+  size_t num_selecionados = 0;
+  for (uint32_t i = 1; i < num_alcancaveis && listar > 0; i++) {
+    uint32_t v = vertice[i];
+    size_t k;
+    if (num_selecionados < listar) {
+      k = num_selecionados++;
+      while (k > 0 && retido[pilha[(k - 1) / 2]] > retido[v]) {
+        pilha[k] = pilha[(k - 1) / 2];
+        k = (k - 1) / 2;
+      }
+      pilha[k] = v;
+    } else if (retido[v] > retido[pilha[0]]) {
+      k = 0;
+      for (;;) {
+        size_t filho = 2 * k + 1;
+        if (filho >= num_selecionados) {
+          break;
+        }
+        if (filho + 1 < num_selecionados &&
+            retido[pilha[filho + 1]] < retido[pilha[filho]]) {
+          filho++;
+        }
+        if (retido[pilha[filho]] >= retido[v]) {
+          break;
+        }
+        pilha[k] = pilha[filho];
+        k = filho;
+      }
+      pilha[k] = v;
+    }
+  }
+
+  // Ordenar por ordem decrescente (ordenaçao do heap)
+  for (size_t fim = num_selecionados; fim > 1; fim--) {
+    uint32_t menor = pilha[0];
+    uint32_t ultimo = pilha[fim - 1];
+    size_t k = 0;
+    for (;;) {
+      size_t filho = 2 * k + 1;
+      if (filho >= fim - 1) {
+        break;
+      }
+      if (filho + 1 < fim - 1 &&
+          retido[pilha[filho + 1]] < retido[pilha[filho]]) {
+        filho++;
+      }
+      if (retido[pilha[filho]] >= retido[ultimo]) {
+        break;
+      }
+      pilha[k] = pilha[filho];
+      k = filho;
+    }
+    pilha[k] = ultimo;
+    pilha[fim - 1] = menor;
+  }
+
+  printf("\n%10s %18s %12s %14s %10s\n", "id", "endereco", "tamanho",
+         "retido", "idom");
+  for (size_t i = 0; i < num_selecionados; i++) {
+    uint32_t v = pilha[i];
+    char dominador[16];
+    if (idom[v] == virtual) {
+      snprintf(dominador, sizeof(dominador), "raiz");
+    } else {
+      snprintf(dominador, sizeof(dominador), "%u", idom[v]);
+    }
+    printf("%10u %#18llx %12llu %14llu %10s\n", v,
+           (unsigned long long)objetos[v].endereco,
+           (unsigned long long)objetos[v].tamanho,
+           (unsigned long long)retido[v], dominador);
+  }
+
+  free(sucessores.inicio);
+  free(sucessores.destino);
+  free(predecessores.inicio);
+  free(predecessores.destino);
+  free(dfs);
+  free(vertice);
+  free(pai);
+  free(semi);
+  free(idom);
+  free(ancestral);
+  free(rotulo);
+  free(balde);
+  free(proximo_balde);
+  free(pilha);
+  free(aresta_atual);
+  free(retido);
+  munmap((void *)mapa, tamanho_ficheiro);
+
+  return 0;
+}
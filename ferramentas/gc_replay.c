@@ -0,0 +1,348 @@
+/**
+ * @file gc_replay.c
+ * @brief Re-execuçao de traços de alocaçao gravados pelo coletor de lixo.
+ *
+ * Esta ferramenta le um ficheiro escrito por gc_gravar_iniciar e executa
+ * novamente todas as chamadas contra a biblioteca, o mais depressa
+ * possivel, medindo o tempo total. Os endereços do traço original sao
+ * traduzidos para os endereços da re-execuçao com uma tabela de dispersao.
+ *
+ * Uso: gc_replay <traco> [tamanho_heap] [repeticoes]
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../src/gc.h"
+#include "../src/gc_formato.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Entrada da tabela endereço original -> endereço re-executado.
+ *
+ * @param original Endereço no traço (0 indica entrada livre).
+ * @param atual Endereço devolvido pela re-execuçao.
+ */
+typedef struct Entrada {
+  uint64_t original;
+  void *atual;
+} entrada_t;
+
+/**
+ * @brief Tabela de dispersao com endereçamento aberto.
+ *
+ * @param entradas Array de entradas.
+ * @param capacidade Numero de entradas (potencia de 2).
+ * @param ocupadas Numero de entradas ocupadas.
+ */
+typedef struct Tabela {
+  entrada_t *entradas;
+  size_t capacidade;
+  size_t ocupadas;
+} tabela_t;
+
+/**
+ * @brief Calcula a posiçao inicial de um endereço na tabela.
+ */
+static size_t tabela_posicao(const tabela_t *tabela, uint64_t original) {
+  original ^= original >> 33;
+  original *= 0xff51afd7ed558ccdull;
+  original ^= original >> 33;
+  return (size_t)original & (tabela->capacidade - 1);
+}
+
+/**
+ * @brief Procura um endereço na tabela.
+ *
+ * @return Endereço re-executado, ou NULL se nao existir.
+ */
+static void *tabela_obter(const tabela_t *tabela, uint64_t original) {
+  if (original == 0) {
+    return NULL;
+  }
+  size_t i = tabela_posicao(tabela, original);
+  while (tabela->entradas[i].original != 0) {
+    if (tabela->entradas[i].original == original) {
+      return tabela->entradas[i].atual;
+    }
+    i = (i + 1) & (tabela->capacidade - 1);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Insere ou substitui um endereço na tabela.
+ *
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+static int tabela_definir(tabela_t *tabela, uint64_t original, void *atual) {
+  if (original == 0) {
+    return 0;
+  }
+
+  // Crescer quando a ocupaçao passa de 50%
+  if (2 * (tabela->ocupadas + 1) > tabela->capacidade) {
+    tabela_t nova = {NULL, tabela->capacidade * 2, 0};
+    nova.entradas = (entrada_t *)calloc(nova.capacidade, sizeof(entrada_t));
+    if (!nova.entradas) {
+      return -1;
+    }
+    for (size_t i = 0; i < tabela->capacidade; i++) {
+      if (tabela->entradas[i].original != 0) {
+        size_t j = tabela_posicao(&nova, tabela->entradas[i].original);
+        while (nova.entradas[j].original != 0) {
+          j = (j + 1) & (nova.capacidade - 1);
+        }
+        nova.entradas[j] = tabela->entradas[i];
+        nova.ocupadas++;
+      }
+    }
+    free(tabela->entradas);
+    *tabela = nova;
+  }
+
+  size_t i = tabela_posicao(tabela, original);
+  while (tabela->entradas[i].original != 0 &&
+         tabela->entradas[i].original != original) {
+    i = (i + 1) & (tabela->capacidade - 1);
+  }
+  if (tabela->entradas[i].original == 0) {
+    tabela->ocupadas++;
+  }
+  tabela->entradas[i].original = original;
+  tabela->entradas[i].atual = atual;
+
+  return 0;
+}
+
+/**
+ * @brief Cursor de leitura sobre os eventos do traço.
+ *
+ * @param atual Proximo byte a ler.
+ * @param fim Fim dos dados.
+ * @param ultimo_endereco Ultimo endereço descodificado (base do delta).
+ * @param erro Indica se o traço terminou a meio de um evento.
+ */
+typedef struct Leitor {
+  const uint8_t *atual;
+  const uint8_t *fim;
+  uint64_t ultimo_endereco;
+  int erro;
+} leitor_t;
+
+/**
+ * @brief Le um inteiro LEB128.
+ */
+static uint64_t ler_inteiro(leitor_t *leitor) {
+  uint64_t valor = 0;
+  unsigned int deslocamento = 0;
+  while (leitor->atual < leitor->fim && deslocamento < 64) {
+    uint8_t byte = *leitor->atual++;
+    valor |= (uint64_t)(byte & 0x7f) << deslocamento;
+    if (!(byte & 0x80)) {
+      return valor;
+    }
+    deslocamento += 7;
+  }
+  leitor->erro = 1;
+  return 0;
+}
+
+/**
+ * @brief Le um endereço codificado como diferença zigzag.
+ */
+static uint64_t ler_endereco(leitor_t *leitor) {
+  uint64_t zigzag = ler_inteiro(leitor);
+  uint64_t delta = (zigzag >> 1) ^ (uint64_t)(-(int64_t)(zigzag & 1));
+  leitor->ultimo_endereco += delta;
+  return leitor->ultimo_endereco;
+}
+
+/**
+ * @brief Devolve o tempo monotono atual em segundos.
+ */
+static double agora(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Ponto de entrada da ferramenta.
+ */
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Uso: %s <traco> [tamanho_heap] [repeticoes]\n", argv[0]);
+    return 1;
+  }
+
+  // Mapear o ficheiro em memoria
+  int fd = open(argv[1], O_RDONLY);
+  if (fd < 0) {
+    perror("open");
+    return 1;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      (size_t)info.st_size < sizeof(gc_traco_cabecalho_t)) {
+    fprintf(stderr, "Ficheiro invalido.\n");
+    close(fd);
+    return 1;
+  }
+  size_t tamanho_ficheiro = (size_t)info.st_size;
+  const uint8_t *mapa = (const uint8_t *)mmap(NULL, tamanho_ficheiro, PROT_READ,
+                                              MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapa == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+
+  const gc_traco_cabecalho_t *cab = (const gc_traco_cabecalho_t *)mapa;
+  if (cab->magia != GC_TRACO_MAGIA || cab->versao != GC_TRACO_VERSAO) {
+    fprintf(stderr, "Ficheiro de traco invalido.\n");
+    munmap((void *)mapa, tamanho_ficheiro);
+    return 1;
+  }
+
+  size_t tamanho_heap = argc > 2 ? (size_t)strtoull(argv[2], NULL, 10)
+                                 : (size_t)cab->tamanho_heap;
+  unsigned long repeticoes = argc > 3 ? strtoul(argv[3], NULL, 10) : 1;
+  if (repeticoes == 0) {
+    repeticoes = 1;
+  }
+
+  tabela_t tabela = {NULL, 1024, 0};
+  unsigned long long contagem[GC_TRACO_REMOVER_REFERENCIA + 1];
+  unsigned long long ignorados = 0;
+  double melhor = 0.0;
+  size_t total_alocado = 0, total_livre = 0, num_objetos = 0;
+
+  for (unsigned long r = 0; r < repeticoes; r++) {
+    tabela.entradas = (entrada_t *)calloc(tabela.capacidade, sizeof(entrada_t));
+    tabela.ocupadas = 0;
+    gc_t *gc = gc_inicializar(tamanho_heap);
+    if (!tabela.entradas || !gc) {
+      fprintf(stderr, "Memoria insuficiente.\n");
+      return 1;
+    }
+    memset(contagem, 0, sizeof(contagem));
+    ignorados = 0;
+
+    leitor_t leitor = {mapa + sizeof(*cab), mapa + tamanho_ficheiro, 0, 0};
+    double inicio = agora();
+
+    while (leitor.atual < leitor.fim && !leitor.erro) {
+      uint8_t evento = *leitor.atual++;
+      uint64_t a, b, tamanho;
+      void *pa, *pb, *novo;
+
+      switch (evento) {
+      case GC_TRACO_ALOCAR:
+        a = ler_endereco(&leitor);
+        tamanho = ler_inteiro(&leitor);
+        novo = gc_alocar(gc, (size_t)tamanho);
+        if (!novo || tabela_definir(&tabela, a, novo) != 0) {
+          ignorados++;
+        }
+        break;
+      case GC_TRACO_REALOCAR:
+        a = ler_endereco(&leitor);
+        b = ler_endereco(&leitor);
+        tamanho = ler_inteiro(&leitor);
+        pa = tabela_obter(&tabela, a);
+        if (!pa) {
+          ignorados++;
+          break;
+        }
+        novo = gc_realocar(gc, pa, (size_t)tamanho);
+        if (b != 0 && (!novo || tabela_definir(&tabela, b, novo) != 0)) {
+          ignorados++;
+        }
+        break;
+      case GC_TRACO_RAIZ:
+      case GC_TRACO_REMOVER_RAIZ:
+        a = ler_endereco(&leitor);
+        pa = tabela_obter(&tabela, a);
+        if (!pa) {
+          ignorados++;
+        } else if (evento == GC_TRACO_RAIZ) {
+          gc_registar_raiz(gc, pa);
+        } else {
+          gc_remover_raiz(gc, pa);
+        }
+        break;
+      case GC_TRACO_REFERENCIA:
+      case GC_TRACO_REMOVER_REFERENCIA:
+        a = ler_endereco(&leitor);
+        b = ler_endereco(&leitor);
+        pa = tabela_obter(&tabela, a);
+        pb = tabela_obter(&tabela, b);
+        if (!pa || !pb) {
+          ignorados++;
+        } else if (evento == GC_TRACO_REFERENCIA) {
+          gc_registar_referencia(gc, pa, pb);
+        } else {
+          gc_remover_referencia(gc, pa, pb);
+        }
+        break;
+      case GC_TRACO_COLETAR:
+        gc_coletar(gc);
+        break;
+      default:
+        fprintf(stderr, "Evento desconhecido %u no traco.\n", evento);
+        leitor.erro = 1;
+        continue;
+      }
+      contagem[evento]++;
+    }
+
+    double duracao = agora() - inicio;
+    if (r == 0 || duracao < melhor) {
+      melhor = duracao;
+    }
+    if (leitor.erro) {
+      fprintf(stderr, "Traco truncado ou corrompido; re-execucao parcial.\n");
+      repeticoes = r + 1;
+    }
+
+    gc_estatisticas(gc, &total_alocado, &total_livre, &num_objetos);
+    gc_finalizar(gc);
+    free(tabela.entradas);
+  }
+
+  unsigned long long total = 0;
+  for (int e = GC_TRACO_ALOCAR; e <= GC_TRACO_REMOVER_REFERENCIA; e++) {
+    total += contagem[e];
+  }
+
+  printf("Tamanho da heap: %zu bytes\n", tamanho_heap);
+  printf("Eventos: %llu (alocar %llu, realocar %llu, raiz %llu, "
+         "remover_raiz %llu, referencia %llu, remover_referencia %llu, "
+         "coletar %llu)\n",
+         total, contagem[GC_TRACO_ALOCAR], contagem[GC_TRACO_REALOCAR],
+         contagem[GC_TRACO_RAIZ], contagem[GC_TRACO_REMOVER_RAIZ],
+         contagem[GC_TRACO_REFERENCIA],
+         contagem[GC_TRACO_REMOVER_REFERENCIA], contagem[GC_TRACO_COLETAR]);
+  if (ignorados > 0) {
+    printf("Eventos ignorados: %llu\n", ignorados);
+  }
+  printf("Melhor tempo em %lu repeticao(oes): %.6f s (%.1f ns/evento)\n",
+         repeticoes, melhor, total ? melhor * 1e9 / (double)total : 0.0);
+  printf("Estado final: %zu bytes alocados, %zu objetos\n", total_alocado,
+         num_objetos);
+
+  munmap((void *)mapa, tamanho_ficheiro);
+
+  return 0;
+}
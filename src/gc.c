@@ -10,6 +10,7 @@
  */
 
 #include "gc.h"
+#include "gc_formato.h"
 #include "gc_interno.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -36,9 +37,35 @@ gc_t *gc_inicializar(size_t tamanho_heap) {
   gc->objetos = NULL;
   gc->num_raizes = 0;
   gc->num_referencias = 0;
+  gc->num_fracas = 0;
+  gc->num_efemeros = 0;
   gc->tamanho_heap = tamanho_heap;
   gc->memoria_usada = 0;
   gc->coletas_realizadas = 0;
+  gc->alocacoes = 0;
+  gc->gravador = NULL;
+  gc->regioes = NULL;
+  gc->paginas = NULL;
+  for (size_t i = 0; i < GC_NUM_CLASSES; i++) {
+    gc->disponiveis[i] = NULL;
+  }
+  gc->paginas_usadas = 0;
+  gc->quota_paginas = 0;
+  gc->contagem_ativa = false;
+  gc->num_decrementos = 0;
+  gc->num_candidatos = 0;
+  gc->num_tipados = 0;
+  gc->visitante = NULL;
+  gc->visitante_contexto = NULL;
+  gc->strings = NULL;
+  gc->num_strings = 0;
+  gc->cap_strings = 0;
+  gc->imagens = NULL;
+  gc->limite_rigido = false;
+  gc->sem_memoria = NULL;
+  gc->sem_memoria_contexto = NULL;
+  gc->sem_memoria_ativa = false;
+  gc_finalizadores_inicializar(gc);
 
   return gc;
 }
@@ -51,43 +78,205 @@ gc_t *gc_inicializar(size_t tamanho_heap) {
  * @return Apontador para a memoria alocada, ou NULL em caso de falha.
  */
 void *gc_alocar(gc_t *gc, size_t tamanho) {
+  return gc_alocar_interno(gc, tamanho, NULL);
+}
+
+/**
+ * @brief Verifica se uma alocaçao cabe no limite rigido do heap.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho da alocaçao em bytes.
+ * @return true se o limite estiver inativo ou a alocaçao couber.
+ */
+static bool gc_limite_permite(gc_t *gc, size_t tamanho) {
+  return !gc->limite_rigido ||
+         (gc->memoria_usada <= gc->tamanho_heap &&
+          tamanho <= gc->tamanho_heap - gc->memoria_usada);
+}
+
+/**
+ * @brief Verifica se uma alocaçao deixa a ocupaçao abaixo do limiar.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho da alocaçao em bytes.
+ * @return true se, depois da alocaçao, ainda nao for preciso coletar.
+ */
+static bool gc_limiar_permite(gc_t *gc, size_t tamanho) {
+  if (tamanho > SIZE_MAX - gc->memoria_usada) {
+    return false; // A soma transbordaria
+  }
+
+  float ocupacao =
+      (float)(gc->memoria_usada + tamanho) / (float)gc->tamanho_heap;
+  return ocupacao <= GC_LIMIAR_COLETA;
+}
+
+/**
+ * @brief Cria um objeto se couber no limite rigido e na quota de paginas.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @param zerado Se nao for NULL, recebe true quando os dados ja estao a zeros.
+ * @return Apontador para os dados do objeto, ou NULL se nao couber.
+ */
+static void *gc_alocar_limitado(gc_t *gc, size_t tamanho, bool *zerado) {
+  if (!gc_limite_permite(gc, tamanho)) {
+    return NULL; // Erro: limite rigido atingido
+  }
+  return gc_alocar_objeto(gc, tamanho, zerado);
+}
+
+/**
+ * @brief Tenta alocar depois de uma coleta de emergencia.
+ *
+ * Faz uma coleta completa e, com o limite rigido ativo, devolve ao
+ * sistema as paginas livres do pool; se a alocaçao continuar a nao
+ * caber, chama a funçao de falta de memoria registada, coleta de novo e
+ * faz uma ultima tentativa.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @param zerado Se nao for NULL, recebe true quando os dados ja estao a zeros.
+ * @return Apontador para os dados do objeto, ou NULL em caso de falha.
+ */
+static void *gc_alocar_emergencia(gc_t *gc, size_t tamanho, bool *zerado) {
+  gc_gravar_suspender(gc);
+  gc_coletar(gc);
+  if (gc->limite_rigido) {
+    gc_pool_descomprometer_antigas(true);
+  }
+  gc_gravar_retomar(gc);
+
+  void *dados = gc_alocar_limitado(gc, tamanho, zerado);
+  if (dados || !gc->sem_memoria || gc->sem_memoria_ativa) {
+    return dados;
+  }
+
+  // A funçao pode largar raizes; alocaçoes feitas nela nao a repetem
+  gc->sem_memoria_ativa = true;
+  gc->sem_memoria(gc, tamanho, gc->sem_memoria_contexto);
+  gc->sem_memoria_ativa = false;
+
+  gc_gravar_suspender(gc);
+  gc_coletar(gc);
+  gc_gravar_retomar(gc);
+
+  return gc_alocar_limitado(gc, tamanho, zerado);
+}
+
+/**
+ * @brief Aloca como gc_alocar, indicando se os dados ja estao a zeros.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @param zerado Se nao for NULL, recebe true quando os dados ja estao a zeros.
+ * @return Apontador para a memoria alocada, ou NULL em caso de falha.
+ */
+void *gc_alocar_interno(gc_t *gc, size_t tamanho, bool *zerado) {
   if (!gc || tamanho == 0) {
     return NULL;
   }
 
-  // Verifica se é necessário coletar lixo antes de alocar.
+  // No modo de contagem, aplicar os decrementos adiados
+  if (gc->contagem_ativa && gc->num_decrementos > 0) {
+    gc_contagem_processar(gc, false);
+  }
+
+  // Verifica se é necessário coletar lixo antes de alocar. No modo de
+  // contagem tenta-se primeiro recolher ciclos, que e mais barato.
+  // A coleta implicita nao e gravada: o replay volta a desencadea-la.
   if (gc_verificar_limiar_coleta(gc)) {
-    gc_coletar(gc);
+    gc_gravar_suspender(gc);
+    if (gc->contagem_ativa) {
+      gc_contagem_processar(gc, true);
+    }
+    if (gc_verificar_limiar_coleta(gc)) {
+      gc_coletar(gc);
+    }
+    gc_gravar_retomar(gc);
   }
 
-  // Criar novo objeto gc
-  gc_object_t *novo_objeto = (gc_object_t *)malloc(sizeof(gc_object_t));
-  if (!novo_objeto) {
-    return NULL;
+  // Sem coletas, as paginas vazias do pool so seriam devolvidas ao sistema
+  // no proximo varrimento
+  if (++gc->alocacoes >= GC_POOL_ALOCACOES_VERIFICAR) {
+    gc->alocacoes = 0;
+    gc_pool_descomprometer_antigas(false);
   }
 
-  // Alocar memoria para os dados do objeto
-  void *dados = malloc(tamanho);
+  void *dados = gc_alocar_limitado(gc, tamanho, zerado);
   if (!dados) {
-    free(novo_objeto);
-    return NULL;
+    // Limite rigido ou quota de paginas esgotados
+    dados = gc_alocar_emergencia(gc, tamanho, zerado);
+    if (!dados) {
+      return NULL;
+    }
   }
 
-  // Inicializar o novo_objeto
-  novo_objeto->dados = dados;
-  novo_objeto->tamanho = tamanho;
-  novo_objeto->marcado = GC_OBJETO_NAO_MARCADO;
+  gc_gravar_evento(gc, GC_TRACO_ALOCAR, dados, NULL, tamanho);
+
+  return dados;
+}
+
+/**
+ * @brief Aloca memoria sem nunca fazer uma coleta.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @return Apontador para a memoria alocada, ou NULL se seria preciso
+ * coletar ou em caso de falha.
+ */
+void *gc_tentar_alocar(gc_t *gc, size_t tamanho) {
+  if (!gc || tamanho == 0) {
+    return NULL;
+  }
 
-  // Adicionar o novo objeto à lista de objetos do coletor
-  novo_objeto->proximo = gc->objetos;
-  gc->objetos = novo_objeto;
+  if (!gc_limiar_permite(gc, tamanho)) {
+    return NULL; // A alocaçao atingiria o limiar: o chamador decide
+  }
 
-  // Atualizar a memoria usada
-  gc->memoria_usada += tamanho;
+  void *dados = gc_alocar_limitado(gc, tamanho, NULL);
+  if (dados) {
+    gc_gravar_evento(gc, GC_TRACO_ALOCAR, dados, NULL, tamanho);
+  }
 
   return dados;
 }
 
+/**
+ * @brief Ativa ou desativa o limite rigido do heap.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param ativar Diferente de zero para ativar, zero para desativar.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_ativar_limite(gc_t *gc, int ativar) {
+  if (!gc) {
+    return -1; // Erro: coletor nulo
+  }
+
+  gc->limite_rigido = ativar != 0;
+  return 0;
+}
+
+/**
+ * @brief Define a funçao chamada quando uma alocaçao falha por falta de
+ * memoria.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param funcao Funçao a chamar, ou NULL para nenhuma.
+ * @param contexto Valor passado a funçao.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_definir_sem_memoria(gc_t *gc, gc_sem_memoria_t funcao, void *contexto) {
+  if (!gc) {
+    return -1; // Erro: coletor nulo
+  }
+
+  gc->sem_memoria = funcao;
+  gc->sem_memoria_contexto = contexto;
+  return 0;
+}
+
 /**
  * @brief Registra uma referência de um objeto para outro.
  * 
@@ -106,14 +295,63 @@ int gc_registar_referencia(gc_t *gc, void *de, void *para) {
     return -2; // Erro: limite de referências atingido
   }
 
+  // Com referencias comprimidas, ambos os objetos têm de estar no heap
+  gc_ref_t ref_de = gc_comprimir(de);
+  gc_ref_t ref_para = gc_comprimir(para);
+  if (!ref_de || !ref_para) {
+    return -3; // Erro: apontador fora do heap comprimido
+  }
+
   // Regista nova referência
-  gc->referencias[gc->num_referencias].de = de;
-  gc->referencias[gc->num_referencias].para = para;
+  gc->referencias[gc->num_referencias].de = ref_de;
+  gc->referencias[gc->num_referencias].para = ref_para;
   gc->num_referencias++;
 
+  // Detetar objetos de regioes que escapam para o heap
+  gc_regiao_registar_referencia(gc, de, para);
+
+  if (gc->contagem_ativa) {
+    gc_contagem_incrementar(gc, para);
+  }
+
+  gc_gravar_evento(gc, GC_TRACO_REFERENCIA, de, para, 0);
+
   return 0;
 }
 
+/**
+ * @brief Remove uma referência de um objeto para outro.
+ *
+ * @param gc Ponteiro para o coletor de lixo.
+ * @param de Ponteiro para o objeto de origem.
+ * @param para Ponteiro para o objeto de destino.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_remover_referencia(gc_t *gc, void *de, void *para) {
+  if (!gc || !de || !para) {
+    return -1; // Erro: um dos apontadores está nulo
+  }
+
+  gc_ref_t ref_de = gc_comprimir(de);
+  gc_ref_t ref_para = gc_comprimir(para);
+  for (size_t i = 0; i < gc->num_referencias; i++) {
+    if (gc->referencias[i].de == ref_de &&
+        gc->referencias[i].para == ref_para) {
+      gc->referencias[i] = gc->referencias[--gc->num_referencias];
+
+      // O decremento e adiado e aplicado em lote
+      if (gc->contagem_ativa) {
+        gc_contagem_decrementar(gc, para);
+      }
+
+      gc_gravar_evento(gc, GC_TRACO_REMOVER_REFERENCIA, de, para, 0);
+      return 0; // Sucesso
+    }
+  }
+
+  return -2; // Erro: referencia nao encontrada
+}
+
 /**
  * @brief Executa o algoritmo de coleta de lixo.
  * 
@@ -130,18 +368,33 @@ size_t gc_coletar(gc_t *gc) {
 
   size_t memoria_anterior = gc->memoria_usada;
 
-  // Desmarcar todos os objetos
+  gc_gravar_evento(gc, GC_TRACO_COLETAR, NULL, NULL, 0);
+
+  // Desmarcar todos os objetos (os das imagens tem as marcas a parte,
+  // para nao escrever nas paginas mapeadas)
   gc_object_t *obj = gc->objetos;
   while (obj) {
-    obj->marcado = GC_OBJETO_NAO_MARCADO;
-    obj = obj->proximo;
+    if (!(obj->bandeiras & GC_BANDEIRA_IMAGEM)) {
+      obj->marcado = GC_OBJETO_NAO_MARCADO;
+    }
+    obj = GC_PROXIMO(obj);
   }
+  gc_imagem_desmarcar(gc);
   
   // Marcar objetos alcançaveis a partir das raízes
   for (size_t i = 0; i < gc->num_raizes; i++) {
     gc_marcar(gc, gc->raizes[i]);
   }
 
+  // Marcar objetos referenciados a partir de regioes ativas
+  gc_marcar_regioes(gc);
+
+  // Marcar valores de efémeros com chaves alcançaveis
+  gc_marcar_efemeros(gc);
+
+  // Manter vivos (e pôr na fila) os objetos com finalizador por correr
+  gc_marcar_finalizaveis(gc);
+
   // Varrer objetos nao marcados
   size_t bytes_libertados = gc_varrer(gc);
 
@@ -161,13 +414,39 @@ void gc_finalizar(gc_t *gc) {
     return; // Erro: coletor de lixo nulo
   }
 
-  // Liberar todos os objetos alocados
-  gc_object_t *obj = gc->objetos;
-  while (obj) {
-    gc_object_t *prox = obj->proximo;
-    free(obj->dados);
-    free(obj);
-    obj = prox;
+  // Terminar a gravaçao de traços, se ativa
+  if (gc->gravador) {
+    gc_gravar_parar(gc);
+  }
+
+  // Correr os finalizadores enquanto os objetos ainda existem
+  gc_finalizadores_terminar(gc);
+
+  // Liberar regioes ainda ativas, sem promover objetos
+  while (gc->regioes) {
+    gc_regiao_t *regiao = gc->regioes;
+    gc->regioes = regiao->proxima;
+    while (regiao->blocos) {
+      gc_regiao_bloco_t *bloco = regiao->blocos;
+      regiao->blocos = bloco->proximo;
+      gc_regiao_libertar_bloco(bloco);
+    }
+    free(regiao);
+  }
+
+  // Devolver todas as paginas ao pool partilhado
+  gc_paginas_libertar_todas(gc);
+
+  // Liberar a tabela de strings internadas
+  free(gc->strings);
+
+  // Desmapear as imagens do heap carregadas
+  while (gc->imagens) {
+    gc_imagem_t *imagem = gc->imagens;
+    gc->imagens = imagem->proxima;
+    gc_pool_desmapear_ficheiro(imagem->inicio, imagem->tamanho);
+    free(imagem->marcas);
+    free(imagem);
   }
 
   // Liberar o coletor de lixo
@@ -193,6 +472,13 @@ int gc_registar_raiz(gc_t *gc, void *raiz) {
 
   // Registra nova raiz
   gc->raizes[gc->num_raizes++] = raiz;
+  gc_regiao_registar(gc, raiz);
+
+  if (gc->contagem_ativa) {
+    gc_contagem_incrementar(gc, raiz);
+  }
+
+  gc_gravar_evento(gc, GC_TRACO_RAIZ, raiz, NULL, 0);
 
   return 0;
 }
@@ -218,6 +504,10 @@ int gc_remover_raiz(gc_t *gc, void *raiz) {
         gc->raizes[j] = gc->raizes[j + 1];
       }
       gc->num_raizes--;
+      if (gc->contagem_ativa) {
+        gc_contagem_decrementar(gc, raiz);
+      }
+      gc_gravar_evento(gc, GC_TRACO_REMOVER_RAIZ, raiz, NULL, 0);
       return 0; // Sucesso
     }
   }
@@ -249,7 +539,9 @@ void gc_estatisticas(gc_t *gc, size_t *total_alocado, size_t *total_livre,
 
   // Cacular total livre
   if (total_livre) {
-    *total_livre = gc->tamanho_heap - gc->memoria_usada;
+    *total_livre = gc->memoria_usada < gc->tamanho_heap
+                       ? gc->tamanho_heap - gc->memoria_usada
+                       : 0;
   }
 
   // Conta o número de objetos
@@ -257,7 +549,7 @@ void gc_estatisticas(gc_t *gc, size_t *total_alocado, size_t *total_livre,
   gc_object_t *obj = gc->objetos;
   while (obj) {
     count++;
-    obj = obj->proximo;
+    obj = GC_PROXIMO(obj);
   }
 
   // Armazena o número de objetos
@@ -294,10 +586,10 @@ gc_object_t *gc_encontrar_objeto(gc_t *gc, void *dados) {
 
   gc_object_t *obj = gc->objetos;
   while (obj) {
-    if (obj->dados == dados) {
+    if (GC_DADOS(obj) == dados) {
       return obj; // Objeto encontrado
     }
-    obj = obj->proximo;
+    obj = GC_PROXIMO(obj);
   }
 
   return NULL; // Objeto não encontrado
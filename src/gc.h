@@ -14,6 +14,10 @@
 
 #include <stddef.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * @brief Estrutura que representa o coletor de lixo.
  *
@@ -30,6 +34,14 @@ typedef struct GC gc_t;
  */
 typedef struct GCObject gc_object_t;
 
+/**
+ * @brief Estrutura que representa uma região de alocação temporária.
+ *
+ * Os objectos de uma região são alocados por incremento e libertados
+ * todos de uma vez no fim da região, sem marcação nem varrimento.
+ */
+typedef struct GCRegiao gc_regiao_t;
+
 /**
  * @brief Estrutura que representa o objecto gerenciado pelo coletor de lixo.
  *
@@ -47,11 +59,44 @@ gc_t *gc_inicializar(size_t tamanho_heap);
  */
 void *gc_alocar(gc_t *gc, size_t tamanho_heap);
 
+/**
+ * @brief Aloca memória sem nunca bloquear numa coleta.
+ *
+ * Ao contrário de gc_alocar, não faz coletas: devolve NULL de imediato
+ * se a alocação levaria a ocupação acima do limiar de coleta, ou se não
+ * cabe no limite rígido (gc_ativar_limite) ou na quota de páginas.
+ * Serve para threads sensíveis à latência que preferem recusar trabalho
+ * a esperar por uma coleta.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @return Apontador para a memoria alocada, ou NULL se seria preciso
+ * coletar ou em caso de falha.
+ */
+void *gc_tentar_alocar(gc_t *gc, size_t tamanho);
+
+/**
+ * @brief Realoca memoria de um objecto gerenciado pelo coletor de lixo.
+ *
+ * O conteudo e copiado para o novo bloco e as raizes e referencias
+ * registadas passam a apontar para ele; so o bloco antigo e libertado.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param ptr Apontador para o objecto a realocar, ou NULL.
+ * @param novo_tamanho Novo tamanho em bytes; 0 liberta o objecto.
+ * @return Apontador para a memoria realocada, ou NULL em caso de falha.
+ */
+void *gc_realocar(gc_t *gc, void *ptr, size_t novo_tamanho);
+
 /**
  * @brief Regista uma referência de um objecto para outro.
  *
  * Esta função é usada para obter as referências entre objectos
  *
+ * Compilada com GC_REFERENCIAS_COMPRIMIDAS, a biblioteca guarda as
+ * referências em 32 bits e só aceita objectos alocados pelo coletor
+ * (todos os coletores do processo partilham um heap máximo de 32 GiB).
+ *
  * @param gc Apontador para o  coletor de lixo a ser usado.
  * @param de Apontador para o objecto de origem.
  * @param para Apontador para o objecto de destino.
@@ -59,6 +104,16 @@ void *gc_alocar(gc_t *gc, size_t tamanho_heap);
  */
 int gc_registar_referencia(gc_t *gc, void *de, void *para);
 
+/**
+ * @brief Remove uma referência registada de um objecto para outro.
+ *
+ * @param gc Apontador para o  coletor de lixo a ser usado.
+ * @param de Apontador para o objecto de origem.
+ * @param para Apontador para o objecto de destino.
+ * @return 0 em caso de sucesso, negativo se a referência não existir.
+ */
+int gc_remover_referencia(gc_t *gc, void *de, void *para);
+
 /**
  * @brief Remove uma referência de um objecto para outro.
  *
@@ -113,4 +168,427 @@ int gc_remover_raiz(gc_t *gc, void *raiz);
 void gc_estatisticas(gc_t *gc, size_t *total_alocado, size_t *total_livre,
                      size_t *num_objetos);
 
+/**
+ * @brief Define a quota de páginas de um coletor.
+ *
+ * Todos os coletores do processo obtêm páginas de um pool partilhado e
+ * devolvem-lhe as páginas que ficam vazias depois de cada coleta. A quota
+ * limita quantas páginas um coletor pode ter ao mesmo tempo; ao atingi-la
+ * é feita uma coleta e, se não bastar, a alocação falha.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param max_paginas Número máximo de páginas (0 para sem limite).
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_definir_quota(gc_t *gc, size_t max_paginas);
+
+/**
+ * @brief Função chamada quando uma alocação não cabe no heap.
+ *
+ * @param gc Coletor onde a alocação falhou.
+ * @param tamanho Tamanho pedido em bytes.
+ * @param contexto Valor passado a gc_definir_sem_memoria.
+ */
+typedef void (*gc_sem_memoria_t)(gc_t *gc, size_t tamanho, void *contexto);
+
+/**
+ * @brief Ativa ou desativa o limite rígido do heap.
+ *
+ * Por omissão tamanho_heap só define o limiar de coleta. Com o limite
+ * ativo, a memória usada nunca ultrapassa tamanho_heap: uma alocação que
+ * não caiba faz uma coleta de emergência (devolvendo ao sistema as
+ * páginas livres do pool) e, se ainda não couber, chama a função de
+ * gc_definir_sem_memoria e tenta uma última vez antes de falhar.
+ *
+ * Objectos promovidos de regiões e imagens carregadas não são limitados.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param ativar Diferente de zero para ativar, zero para desativar.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_ativar_limite(gc_t *gc, int ativar);
+
+/**
+ * @brief Define a função chamada quando uma alocação falha por falta de
+ * memória, depois da coleta de emergência.
+ *
+ * A função pode libertar memória (por exemplo, removendo raízes de
+ * caches); o coletor faz então outra coleta e tenta a alocação de novo.
+ * Alocações feitas dentro da função não voltam a chamá-la.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param funcao Função a chamar, ou NULL para nenhuma.
+ * @param contexto Valor passado à função.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_definir_sem_memoria(gc_t *gc, gc_sem_memoria_t funcao, void *contexto);
+
+/**
+ * @brief Retorna estatísticas do pool de páginas partilhado.
+ *
+ * @param paginas_em_uso Apontador onde será guardado o número de páginas
+ * entregues a coletores.
+ * @param paginas_livres Apontador onde será guardado o número de páginas
+ * livres ainda residentes em memória.
+ * @param paginas_devolvidas Apontador onde será guardado o número de
+ * páginas livres já devolvidas ao sistema operativo.
+ */
+void gc_pool_estatisticas(size_t *paginas_em_uso, size_t *paginas_livres,
+                          size_t *paginas_devolvidas);
+
+/**
+ * @brief Opções do pool de páginas.
+ *
+ * @param GC_POOL_PAGINAS_ENORMES Pede páginas enormes transparentes (THP)
+ * para os blocos do pool e objetos grandes, reduzindo falhas de TLB na
+ * marcação de heaps grandes. Devolver uma página livre ao sistema parte
+ * a página enorme que a contém.
+ * @param GC_POOL_MADV_FREE Usa MADV_FREE em vez de MADV_DONTNEED: o
+ * sistema só recupera a memória quando precisa dela, mas o RSS pode não
+ * descer de imediato.
+ */
+#define GC_POOL_PAGINAS_ENORMES 1
+#define GC_POOL_MADV_FREE 2
+
+/**
+ * @brief Configura a devolução de memória ao sistema operativo.
+ *
+ * Depois de cada varrimento, as páginas vazias voltam ao pool partilhado.
+ * As que estão livres há mais do que atraso_ms são devolvidas ao sistema
+ * com madvise, o que reduz o RSS do processo. Não há thread para isso: o
+ * atraso é verificado no fim de cada varrimento, quando se obtém ou
+ * devolve uma página do pool e a cada poucas centenas de alocações. Um
+ * processo que deixe de alocar deve chamar gc_pool_descomprometer. Objetos
+ * grandes são devolvidos ao sistema assim que são libertados.
+ *
+ * @param atraso_ms Tempo em ms antes de devolver uma página livre (0 para
+ * imediato, negativo para nunca). Por omissão é 1000.
+ * @param opcoes Combinação de GC_POOL_PAGINAS_ENORMES e GC_POOL_MADV_FREE.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_pool_configurar(long atraso_ms, int opcoes);
+
+/**
+ * @brief Devolve imediatamente ao sistema todas as páginas livres do pool.
+ *
+ * @return Número de páginas devolvidas.
+ */
+size_t gc_pool_descomprometer(void);
+
+/**
+ * @brief Escreve um snapshot binario do grafo de objetos.
+ *
+ * O ficheiro contem todos os objetos com o seu tamanho, as raizes e as
+ * referencias entre objetos, e pode ser analisado pela ferramenta
+ * gc_analisar para calcular dominadores e tamanhos retidos. Conta como
+ * raiz e como aresta tudo o que a coleta segue: campos visitados pelas
+ * funções de marcação dos tipos, efémeros, referências a partir de
+ * regiões e objectos à espera do finalizador.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param caminho Caminho do ficheiro a criar.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_snapshot(gc_t *gc, const char *caminho);
+
+/**
+ * @brief Grava o heap, as raízes e as referências numa imagem relocável.
+ *
+ * A imagem guarda o conteúdo dos objectos no formato de memória do
+ * coletor e pode ser carregada por gc_carregar_imagem noutro processo.
+ * Ao carregar fora do endereço preferido só os campos que guardam o
+ * destino de uma referência registada são corrigidos; outros apontadores
+ * entre objectos não devem ser usados. Objectos com tipo (gc_alocar_tipo)
+ * não são suportados e os finalizadores não são gravados.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param caminho Caminho do ficheiro a criar.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_salvar_imagem(gc_t *gc, const char *caminho);
+
+/**
+ * @brief Cria um coletor a partir de uma imagem gravada por
+ * gc_salvar_imagem.
+ *
+ * O ficheiro é mapeado em cópia-na-escrita e alterações aos objectos não
+ * chegam ao ficheiro. A carga lê os cabeçalhos de todos os objectos; as
+ * coletas guardam as marcas fora da imagem, por isso as páginas só
+ * passam a cópias privadas quando o programa escreve nos objectos,
+ * quando a imagem é carregada fora do endereço preferido (ou com
+ * referências comprimidas, em que a lista é sempre religada), com a
+ * contagem de referências ativa, ou quando a varredura retira da lista
+ * objectos da imagem que morreram. A memória dos objectos da imagem só
+ * é devolvida em gc_finalizar.
+ *
+ * @param caminho Caminho do ficheiro de imagem.
+ * @return Apontador para o novo coletor, ou NULL em caso de erro.
+ */
+gc_t *gc_carregar_imagem(const char *caminho);
+
+/**
+ * @brief Regista uma referência fraca.
+ *
+ * O campo indicado guarda um apontador para um objecto que não é mantido
+ * vivo por esta referência. Quando o objecto é libertado, o coletor
+ * escreve NULL no campo.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param campo Endereço do apontador que guarda a referência fraca.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_registar_referencia_fraca(gc_t *gc, void **campo);
+
+/**
+ * @brief Remove uma referência fraca registada.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param campo Endereço do apontador registado.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_remover_referencia_fraca(gc_t *gc, void **campo);
+
+/**
+ * @brief Regista um efémero (entrada chave/valor de uma cache).
+ *
+ * O valor é mantido vivo apenas enquanto a chave for alcançável por outro
+ * caminho. Quando a chave é libertada a entrada desaparece, permitindo
+ * caches que encolhem sozinhas. Registar uma chave existente substitui
+ * o valor.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param chave Apontador para o objecto chave.
+ * @param valor Apontador para o objecto valor.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_registar_efemero(gc_t *gc, void *chave, void *valor);
+
+/**
+ * @brief Obtém o valor associado a uma chave na tabela de efémeros.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param chave Apontador para o objecto chave.
+ * @return Apontador para o valor, ou NULL se a chave não existir.
+ */
+void *gc_obter_efemero(gc_t *gc, void *chave);
+
+/**
+ * @brief Remove a entrada de uma chave da tabela de efémeros.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param chave Apontador para o objecto chave.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_remover_efemero(gc_t *gc, void *chave);
+
+/**
+ * @brief Inicia uma região de alocação temporária.
+ *
+ * Útil para dados de trabalho de um pedido, que morrem todos juntos.
+ * Os objectos da região mantêm vivos os objectos do heap que referenciam.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param capacidade Capacidade do primeiro bloco em bytes (0 para o padrão).
+ * @return Apontador para a região, ou NULL em caso de falha.
+ */
+gc_regiao_t *gc_regiao_inicio(gc_t *gc, size_t capacidade);
+
+/**
+ * @brief Aloca memória numa região.
+ *
+ * @param regiao Apontador para a região a ser usada.
+ * @param tamanho Tamanho da memória a ser alocada em bytes.
+ * @return Apontador para a memória alocada, ou NULL em caso de falha.
+ */
+void *gc_regiao_alocar(gc_regiao_t *regiao, size_t tamanho);
+
+/**
+ * @brief Valor devolvido por gc_regiao_fim quando a promoção falha.
+ */
+#define GC_REGIAO_FALHA ((size_t)-1)
+
+/**
+ * @brief Termina uma região e liberta toda a sua memória.
+ *
+ * Objectos da região referenciados a partir do heap (registados com
+ * gc_registar_referencia), e os objectos da região alcançáveis a partir
+ * deles, são promovidos: copiados para o heap, com as referências
+ * registadas e os apontadores nos objectos de origem atualizados.
+ * Raízes que apontem para a região deixam de estar registadas.
+ *
+ * Se faltar memória para as cópias, nada é promovido e a região continua
+ * ativa (e utilizável); pode voltar a terminar-se depois de libertar
+ * memória.
+ *
+ * @param regiao Apontador para a região a terminar.
+ * @return Número de bytes libertados, ou GC_REGIAO_FALHA se a promoção
+ * falhou.
+ */
+size_t gc_regiao_fim(gc_regiao_t *regiao);
+
+/**
+ * @brief Inicia a gravação de um traço de alocações.
+ *
+ * Todas as chamadas a gc_alocar, gc_realocar, gc_registar_raiz,
+ * gc_remover_raiz, gc_registar_referencia e gc_coletar passam a ser
+ * registadas num ficheiro binario compacto, que pode ser re-executado
+ * pela ferramenta gc_replay. O estado atual do heap e gravado no início.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param caminho Caminho do ficheiro a criar.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_gravar_iniciar(gc_t *gc, const char *caminho);
+
+/**
+ * @brief Termina a gravação do traço de alocações.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_gravar_parar(gc_t *gc);
+
+/**
+ * @brief Devolve a cópia partilhada de uma string, criando-a se necessário.
+ *
+ * Chamadas com o mesmo conteúdo devolvem o mesmo apontador enquanto a
+ * string estiver viva. A tabela não mantém as strings vivas: quando
+ * deixam de ser alcançáveis são coletadas como qualquer outro objecto.
+ * A string devolvida é partilhada e não deve ser modificada.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param str String a internar.
+ * @return Apontador para a string internada, ou NULL em caso de falha.
+ */
+const char *gc_internar_string(gc_t *gc, const char *str);
+
+/**
+ * @brief Função que percorre os campos de um objecto durante a marcação.
+ *
+ * Deve chamar gc_visitar para cada objecto referenciado pelo objecto
+ * em dados. Permite descrever as referências de um tipo uma só vez, sem
+ * chamar gc_registar_referencia por cada ligação.
+ */
+typedef void (*gc_tracador_t)(gc_t *gc, void *dados);
+
+/**
+ * @brief Regista um tipo de objecto com a sua função de marcação.
+ *
+ * Os tipos são partilhados por todos os coletores do processo.
+ *
+ * @param tracador Função de marcação dos objectos do tipo.
+ * @return Identificador do tipo (positivo), ou negativo em caso de erro.
+ */
+int gc_registar_tipo(gc_tracador_t tracador);
+
+/**
+ * @brief Aloca um objecto de um tipo registado com gc_registar_tipo.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @param tipo Identificador do tipo (0 para nenhum).
+ * @return Apontador para a memoria alocada, ou NULL em caso de falha.
+ */
+void *gc_alocar_tipo(gc_t *gc, size_t tamanho, int tipo);
+
+/**
+ * @brief Marca um objecto referenciado. Só deve ser chamada por funções
+ * de marcação (gc_tracador_t).
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param objeto Apontador para o objecto referenciado, ou NULL.
+ */
+void gc_visitar(gc_t *gc, void *objeto);
+
+/**
+ * @brief Ativa ou desativa o modo de contagem de referências.
+ *
+ * Neste modo cada objecto conta as referências registadas e as raízes que
+ * apontam para ele. Os decrementos (gc_remover_referencia,
+ * gc_remover_raiz) são adiados e aplicados em lote na alocação seguinte;
+ * objectos cuja contagem chega a zero são libertados nesse momento, sem
+ * esperar por gc_coletar. Os ciclos de lixo são recolhidos por
+ * gc_coletar_ciclos, chamada também antes de uma coleta por limiar.
+ *
+ * Enquanto existirem objectos com tipo (gc_alocar_tipo) ou efémeros, cujas
+ * ligações não são contadas, ou objectos com finalizador (vivos ou à
+ * espera na fila), a contagem fica sem efeito e só a coleta completa
+ * liberta objectos. Em particular, gc_make (gc.hpp) cria sempre objectos
+ * com tipo, por isso a contagem não serve para heaps da camada C++.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param ativar Diferente de zero para ativar, zero para desativar.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_ativar_contagem(gc_t *gc, int ativar);
+
+/**
+ * @brief Aplica os decrementos adiados e recolhe ciclos de lixo.
+ *
+ * Só tem efeito no modo de contagem de referências.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @return Número de bytes libertados.
+ */
+size_t gc_coletar_ciclos(gc_t *gc);
+
+/**
+ * @brief Função que liberta os recursos nativos de um objecto morto.
+ *
+ * @param dados Apontador para os dados do objecto.
+ */
+typedef void (*gc_finalizador_t)(void *dados);
+
+/**
+ * @brief Aloca um objecto com finalizador.
+ *
+ * Quando o objecto fica inalcançável, a coleta não o liberta: mantém-no
+ * vivo (com tudo o que ele referencia) e põe-no numa fila. O finalizador
+ * corre depois, fora da coleta, em gc_executar_finalizadores ou na
+ * thread de gc_iniciar_thread_finalizadores, e o objecto é libertado na
+ * coleta seguinte se continuar inalcançável. Cada finalizador corre uma
+ * só vez e a ordem entre objectos não é garantida.
+ *
+ * Os finalizadores não devem chamar funções do coletor nem alterar
+ * campos com referências. Um objecto libertado explicitamente
+ * (gc_realocar com tamanho 0) tem o finalizador executado de imediato.
+ * Em gc_finalizar correm os finalizadores pendentes e os dos objectos
+ * ainda vivos.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @param finalizador Função a chamar com os dados do objecto.
+ * @return Apontador para a memoria alocada, ou NULL em caso de falha.
+ */
+void *gc_alocar_com_finalizador(gc_t *gc, size_t tamanho,
+                                gc_finalizador_t finalizador);
+
+/**
+ * @brief Corre, em lotes, finalizadores de objectos mortos.
+ *
+ * Não bloqueia: se a thread de finalizadores estiver a correr um lote,
+ * devolve 0 de imediato.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @param maximo Número máximo de finalizadores a correr (0 para todos).
+ * @return Número de finalizadores executados.
+ */
+size_t gc_executar_finalizadores(gc_t *gc, size_t maximo);
+
+/**
+ * @brief Inicia uma thread dedicada aos finalizadores.
+ *
+ * A thread acorda quando uma coleta põe objectos na fila e corre os
+ * finalizadores em lotes, em paralelo com o resto do programa. Termina
+ * em gc_finalizar.
+ *
+ * @param gc Apontador para o coletor de lixo a ser usado.
+ * @return 0 em caso de sucesso, negativo em caso de erro.
+ */
+int gc_iniciar_thread_finalizadores(gc_t *gc);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // !GC_H
\ No newline at end of file
@@ -0,0 +1,232 @@
+/**
+ * @file gc.hpp
+ * @brief Camada C++ (só cabeçalho) sobre o coletor de lixo.
+ *
+ * Define gc_ptr<T>, uma referência para usar como campo de objectos
+ * geridos, gc_root<T>, uma raiz RAII que é registada na construção e
+ * removida na destruição (também quando há excepções), e gc_make<T>, que
+ * aloca e constrói um objecto no heap do coletor.
+ *
+ * Os campos gc_ptr de um tipo são declarados uma vez com GC_CAMPOS; a
+ * função de marcação do tipo é gerada em tempo de compilação a partir
+ * dessa lista, sem chamadas a gc_registar_referencia por cada ligação.
+ *
+ * Requer C++17.
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#ifndef GC_HPP
+#define GC_HPP
+
+#include "gc.h"
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Referência para um objecto gerido, para usar como campo.
+ *
+ * Não é raiz: o objecto referenciado só se mantém vivo se o objecto que
+ * contém o campo estiver vivo e o tipo o listar em GC_CAMPOS. Copiar um
+ * gc_ptr não tem custo.
+ */
+template <class T> class gc_ptr {
+public:
+  constexpr gc_ptr() noexcept : ptr_(nullptr) {}
+  constexpr gc_ptr(std::nullptr_t) noexcept : ptr_(nullptr) {}
+  explicit gc_ptr(T *ptr) noexcept : ptr_(ptr) {}
+
+  T *get() const noexcept { return ptr_; }
+  T &operator*() const noexcept { return *ptr_; }
+  T *operator->() const noexcept { return ptr_; }
+  explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+  friend bool operator==(const gc_ptr &a, const gc_ptr &b) noexcept {
+    return a.ptr_ == b.ptr_;
+  }
+  friend bool operator!=(const gc_ptr &a, const gc_ptr &b) noexcept {
+    return a.ptr_ != b.ptr_;
+  }
+
+private:
+  T *ptr_;
+};
+
+/**
+ * @brief Raiz RAII para um objecto gerido.
+ *
+ * Regista o objecto como raiz na construção e remove-o na destruição.
+ * Só pode ser movida: mover transfere o registo, sem o remover e voltar
+ * a registar, e a origem fica vazia.
+ */
+template <class T> class gc_root {
+public:
+  gc_root() noexcept : gc_(nullptr), ptr_(nullptr) {}
+
+  /**
+   * @brief Regista ptr como raiz de gc.
+   * @throws std::bad_alloc Se o limite de raízes foi atingido.
+   */
+  gc_root(gc_t *gc, T *ptr) : gc_(gc), ptr_(nullptr) {
+    if (ptr && gc_registar_raiz(gc, vazio(ptr)) != 0) {
+      throw std::bad_alloc();
+    }
+    ptr_ = ptr;
+  }
+
+  gc_root(gc_t *gc, gc_ptr<T> ptr) : gc_root(gc, ptr.get()) {}
+
+  gc_root(const gc_root &) = delete;
+  gc_root &operator=(const gc_root &) = delete;
+
+  gc_root(gc_root &&outra) noexcept : gc_(outra.gc_), ptr_(outra.ptr_) {
+    outra.ptr_ = nullptr;
+  }
+
+  gc_root &operator=(gc_root &&outra) noexcept {
+    if (this != &outra) {
+      reset();
+      gc_ = outra.gc_;
+      ptr_ = outra.ptr_;
+      outra.ptr_ = nullptr;
+    }
+    return *this;
+  }
+
+  ~gc_root() { reset(); }
+
+  /**
+   * @brief Remove a raiz; o objecto pode ser coletado.
+   */
+  void reset() noexcept {
+    if (ptr_) {
+      gc_remover_raiz(gc_, vazio(ptr_));
+      ptr_ = nullptr;
+    }
+  }
+
+  T *get() const noexcept { return ptr_; }
+  T &operator*() const noexcept { return *ptr_; }
+  T *operator->() const noexcept { return ptr_; }
+  explicit operator bool() const noexcept { return ptr_ != nullptr; }
+  operator gc_ptr<T>() const noexcept { return gc_ptr<T>(ptr_); }
+  gc_t *coletor() const noexcept { return gc_; }
+
+private:
+  static void *vazio(T *ptr) noexcept {
+    return const_cast<void *>(static_cast<const void *>(ptr));
+  }
+
+  gc_t *gc_;
+  T *ptr_;
+};
+
+/**
+ * @brief Lista dos campos de um tipo que referenciam objectos geridos.
+ *
+ * Por omissão um tipo não tem campos (e não precisa de função de
+ * marcação). Especializa-se com GC_CAMPOS.
+ */
+template <class T> struct gc_campos {
+  static constexpr std::tuple<> lista{};
+};
+
+/**
+ * @brief Declara os campos geridos de um tipo (no espaço de nomes global).
+ *
+ * Cada campo é um apontador para membro do tipo gc_ptr<U>, array de
+ * gc_ptr<U>, ou outro tipo com GC_CAMPOS (marcado recursivamente).
+ *
+ * Exemplo: GC_CAMPOS(no_t, &no_t::esquerdo, &no_t::direito);
+ */
+#define GC_CAMPOS(Tipo, ...)                                                   \
+  template <> struct gc_campos<Tipo> {                                         \
+    static constexpr auto lista = std::make_tuple(__VA_ARGS__);                \
+  }
+
+namespace gc_detalhe {
+
+template <class T> void tracar(gc_t *gc, const T &valor);
+
+template <class U> void tracar(gc_t *gc, const gc_ptr<U> &campo) {
+  gc_visitar(gc, const_cast<void *>(static_cast<const void *>(campo.get())));
+}
+
+template <class U, std::size_t N> void tracar(gc_t *gc, const U (&array)[N]) {
+  for (const U &elemento : array) {
+    tracar(gc, elemento);
+  }
+}
+
+/**
+ * @brief Marca os campos de um valor, pela ordem de gc_campos<T>::lista.
+ */
+template <class T> void tracar(gc_t *gc, const T &valor) {
+  std::apply([&](auto... campos) { (tracar(gc, valor.*campos), ...); },
+             gc_campos<T>::lista);
+}
+
+/**
+ * @brief Função de marcação gerada para T (gc_tracador_t).
+ */
+template <class T> void tracar_tipo(gc_t *gc, void *dados) {
+  tracar(gc, *static_cast<const T *>(dados));
+}
+
+/**
+ * @brief Identificador do tipo T, registado na primeira utilização.
+ *
+ * Tipos sem campos geridos não precisam de função de marcação (tipo 0).
+ *
+ * @throws std::bad_alloc Se o limite de tipos foi atingido.
+ */
+template <class T> int tipo() {
+  if constexpr (std::tuple_size<std::decay_t<
+                    decltype(gc_campos<T>::lista)>>::value == 0) {
+    return 0;
+  } else {
+    static const int id = [] {
+      int registado = gc_registar_tipo(&tracar_tipo<T>);
+      if (registado < 0) {
+        throw std::bad_alloc();
+      }
+      return registado;
+    }();
+    return id;
+  }
+}
+
+} // namespace gc_detalhe
+
+/**
+ * @brief Aloca e constrói um T no heap do coletor, devolvendo a sua raiz.
+ *
+ * O objecto é posto a zeros e registado como raiz antes de o construtor
+ * correr, para que uma coleta desencadeada pelo construtor encontre
+ * apenas gc_ptr nulos ou válidos. O coletor não chama destrutores.
+ *
+ * @throws std::bad_alloc Se a alocação falhar.
+ */
+template <class T, class... Args> gc_root<T> gc_make(gc_t *gc, Args &&...args) {
+  static_assert(alignof(T) <= 16, "alinhamento maior do que o do coletor");
+  static_assert(std::is_trivially_destructible<T>::value,
+                "o coletor nao chama destrutores");
+
+  void *dados = gc_alocar_tipo(gc, sizeof(T), gc_detalhe::tipo<T>());
+  if (!dados) {
+    throw std::bad_alloc();
+  }
+  std::memset(dados, 0, sizeof(T));
+
+  gc_root<T> raiz(gc, static_cast<T *>(dados));
+  ::new (dados) T(std::forward<Args>(args)...);
+
+  return raiz;
+}
+
+#endif // !GC_HPP
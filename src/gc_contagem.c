@@ -0,0 +1,411 @@
+/**
+ * @file gc_contagem.c
+ * @brief Implementaçao do modo de contagem de referencias.
+ *
+ * Este arquivo contem o modo hibrido opcional em que cada objeto conta as
+ * referencias registadas e as raizes que apontam para ele. Os incrementos
+ * sao imediatos; os decrementos sao adiados e aplicados em lote. Objetos
+ * cuja contagem chega a zero sao libertados logo, sem esperar pela
+ * marcaçao. Os ciclos sao recolhidos por eliminaçao experimental (Bacon e
+ * Rajan) a partir dos objetos cuja contagem desceu sem chegar a zero.
+ *
+ * A marcaçao continua a ser o mecanismo de reserva: cada varrimento
+ * recalcula as contagens a partir do grafo que sobreviveu.
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#include "gc.h"
+#include "gc_interno.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @brief Cores da recolha de ciclos, guardadas nas bandeiras do objeto.
+ *
+ * @param GC_COR_PRETA Em uso, ou ja processado.
+ * @param GC_COR_CINZENTA Possivel membro de um ciclo.
+ * @param GC_COR_BRANCA Membro de um ciclo de lixo.
+ * @param GC_COR_ROXA Possivel raiz de um ciclo.
+ */
+#define GC_COR_MASCARA 0x30
+#define GC_COR_PRETA 0x00
+#define GC_COR_CINZENTA 0x10
+#define GC_COR_BRANCA 0x20
+#define GC_COR_ROXA 0x30
+
+#define GC_COR(obj) ((obj)->bandeiras & GC_COR_MASCARA)
+#define GC_PINTAR(obj, cor)                                                    \
+  ((obj)->bandeiras = (uint8_t)(((obj)->bandeiras & ~GC_COR_MASCARA) | (cor)))
+
+/**
+ * @brief Funçao aplicada a cada filho de um objeto.
+ */
+typedef void (*gc_visita_t)(gc_t *gc, gc_object_t *filho);
+
+/**
+ * @brief Aplica uma funçao a cada objeto do heap referenciado por obj.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto.
+ * @param visita Funçao a aplicar.
+ */
+static void gc_contagem_filhos(gc_t *gc, gc_object_t *obj, gc_visita_t visita) {
+  gc_ref_t ref = gc_comprimir(GC_DADOS(obj));
+  for (size_t i = 0; i < gc->num_referencias; i++) {
+    if (gc->referencias[i].de == ref) {
+      gc_object_t *filho =
+          gc_encontrar_objeto(gc, gc_descomprimir(gc->referencias[i].para));
+      if (filho) {
+        visita(gc, filho);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Indica se a contagem pode libertar objetos.
+ *
+ * Ligaçoes descritas por funçoes de marcaçao e valores de efémeros nao
+ * sao contadas, e objetos com finalizador tem de passar pela fila;
+ * enquanto existirem, so a marcaçao liberta objetos.
+ */
+static bool gc_contagem_pode_libertar(gc_t *gc) {
+  return gc->num_tipados == 0 && gc->num_efemeros == 0 &&
+         gc->num_finalizaveis == 0 && !gc_finalizadores_pendentes(gc);
+}
+
+/**
+ * @brief Marca um objeto como morto; e libertado por gc_varrer_libertados.
+ */
+static void gc_contagem_libertar(gc_object_t *obj) {
+  obj->bandeiras |= GC_BANDEIRA_LIBERTADA;
+}
+
+static void gc_contagem_aplicar_decremento(gc_t *gc, gc_object_t *obj);
+
+/**
+ * @brief Objeto com contagem zero: decrementa os filhos e liberta-o, a
+ * menos que esteja no buffer de candidatos (MarkRoots trata dele).
+ */
+static void gc_contagem_largar(gc_t *gc, gc_object_t *obj) {
+  gc_contagem_filhos(gc, obj, gc_contagem_aplicar_decremento);
+  GC_PINTAR(obj, GC_COR_PRETA);
+  if (!(obj->bandeiras & GC_BANDEIRA_CANDIDATA)) {
+    gc_contagem_libertar(obj);
+  }
+}
+
+/**
+ * @brief Objeto cuja contagem desceu sem chegar a zero: pode ser a raiz
+ * de um ciclo de lixo.
+ */
+static void gc_contagem_possivel_raiz(gc_t *gc, gc_object_t *obj) {
+  if (GC_COR(obj) == GC_COR_ROXA) {
+    return;
+  }
+  GC_PINTAR(obj, GC_COR_ROXA);
+  if (!(obj->bandeiras & GC_BANDEIRA_CANDIDATA) &&
+      gc->num_candidatos < GC_MAX_CANDIDATOS) {
+    obj->bandeiras |= GC_BANDEIRA_CANDIDATA;
+    gc->candidatos[gc->num_candidatos++] = obj;
+  }
+}
+
+/**
+ * @brief Aplica um decremento a um objeto.
+ */
+static void gc_contagem_aplicar_decremento(gc_t *gc, gc_object_t *obj) {
+  if (obj->contagem == 0 || obj->contagem == GC_CONTAGEM_MAX ||
+      (obj->bandeiras & GC_BANDEIRA_LIBERTADA)) {
+    return; // Referencia nao contada, contagem fixa ou objeto ja morto
+  }
+
+  obj->contagem--;
+  if (obj->contagem == 0) {
+    gc_contagem_largar(gc, obj);
+  } else {
+    gc_contagem_possivel_raiz(gc, obj);
+  }
+}
+
+/**
+ * @brief Eliminaçao experimental: retira as referencias internas ao
+ * subgrafo alcançavel a partir de um objeto.
+ */
+static void gc_contagem_marcar_cinzento(gc_t *gc, gc_object_t *obj);
+
+static void gc_contagem_decrementar_cinzento(gc_t *gc, gc_object_t *filho) {
+  if (filho->contagem > 0 && filho->contagem != GC_CONTAGEM_MAX) {
+    filho->contagem--;
+  }
+  gc_contagem_marcar_cinzento(gc, filho);
+}
+
+static void gc_contagem_marcar_cinzento(gc_t *gc, gc_object_t *obj) {
+  if (GC_COR(obj) == GC_COR_CINZENTA) {
+    return;
+  }
+  GC_PINTAR(obj, GC_COR_CINZENTA);
+  gc_contagem_filhos(gc, obj, gc_contagem_decrementar_cinzento);
+}
+
+/**
+ * @brief Repoe as contagens do subgrafo de um objeto que continua vivo.
+ */
+static void gc_contagem_pintar_preto(gc_t *gc, gc_object_t *obj);
+
+static void gc_contagem_incrementar_preto(gc_t *gc, gc_object_t *filho) {
+  if (filho->contagem != GC_CONTAGEM_MAX) {
+    filho->contagem++;
+  }
+  if (GC_COR(filho) != GC_COR_PRETA) {
+    gc_contagem_pintar_preto(gc, filho);
+  }
+}
+
+static void gc_contagem_pintar_preto(gc_t *gc, gc_object_t *obj) {
+  GC_PINTAR(obj, GC_COR_PRETA);
+  gc_contagem_filhos(gc, obj, gc_contagem_incrementar_preto);
+}
+
+/**
+ * @brief Objetos cinzentos com contagem positiva sao referenciados de fora
+ * do subgrafo e ficam pretos; os restantes ficam brancos (lixo).
+ */
+static void gc_contagem_examinar(gc_t *gc, gc_object_t *obj) {
+  if (GC_COR(obj) != GC_COR_CINZENTA) {
+    return;
+  }
+  if (obj->contagem > 0) {
+    gc_contagem_pintar_preto(gc, obj);
+  } else {
+    GC_PINTAR(obj, GC_COR_BRANCA);
+    gc_contagem_filhos(gc, obj, gc_contagem_examinar);
+  }
+}
+
+/**
+ * @brief Liberta os objetos brancos alcançaveis a partir de um objeto.
+ */
+static void gc_contagem_recolher_branco(gc_t *gc, gc_object_t *obj) {
+  if (GC_COR(obj) != GC_COR_BRANCA ||
+      (obj->bandeiras & GC_BANDEIRA_CANDIDATA)) {
+    return;
+  }
+  GC_PINTAR(obj, GC_COR_PRETA);
+  gc_contagem_filhos(gc, obj, gc_contagem_recolher_branco);
+  gc_contagem_libertar(obj);
+}
+
+/**
+ * @brief Recolhe os ciclos de lixo entre os candidatos (Bacon e Rajan).
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+static void gc_contagem_recolher_ciclos(gc_t *gc) {
+  // Marcar a cinzento a partir dos candidatos ainda roxos
+  size_t mantidos = 0;
+  for (size_t i = 0; i < gc->num_candidatos; i++) {
+    gc_object_t *obj = gc->candidatos[i];
+    if (GC_COR(obj) == GC_COR_ROXA && obj->contagem > 0) {
+      gc_contagem_marcar_cinzento(gc, obj);
+      gc->candidatos[mantidos++] = obj;
+    } else {
+      obj->bandeiras &= (uint8_t)~GC_BANDEIRA_CANDIDATA;
+      if (GC_COR(obj) == GC_COR_PRETA && obj->contagem == 0) {
+        gc_contagem_libertar(obj);
+      }
+    }
+  }
+  gc->num_candidatos = mantidos;
+
+  for (size_t i = 0; i < gc->num_candidatos; i++) {
+    gc_contagem_examinar(gc, gc->candidatos[i]);
+  }
+
+  for (size_t i = 0; i < gc->num_candidatos; i++) {
+    gc_object_t *obj = gc->candidatos[i];
+    obj->bandeiras &= (uint8_t)~GC_BANDEIRA_CANDIDATA;
+    gc_contagem_recolher_branco(gc, obj);
+  }
+  gc->num_candidatos = 0;
+}
+
+/**
+ * @brief Incrementa a contagem de um objeto referenciado.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param dados Apontador para os dados do objeto (ignorado se nao for do heap).
+ */
+void gc_contagem_incrementar(gc_t *gc, void *dados) {
+  gc_object_t *obj = gc_encontrar_objeto(gc, dados);
+  if (!obj || obj->contagem == GC_CONTAGEM_MAX) {
+    return; // Fora do heap ou contagem fixa
+  }
+
+  obj->contagem++;
+  GC_PINTAR(obj, GC_COR_PRETA);
+}
+
+/**
+ * @brief Adia o decremento da contagem de um objeto.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param dados Apontador para os dados do objeto (ignorado se nao for do heap).
+ */
+void gc_contagem_decrementar(gc_t *gc, void *dados) {
+  gc_object_t *obj = gc_encontrar_objeto(gc, dados);
+  if (!obj) {
+    return; // Fora do heap
+  }
+
+  if (gc->num_decrementos >= GC_MAX_DECREMENTOS) {
+    gc_contagem_processar(gc, false);
+  }
+  gc->decrementos[gc->num_decrementos++] = obj;
+}
+
+/**
+ * @brief Aplica os decrementos adiados e liberta os objetos mortos.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param ciclos Se true, recolhe tambem os ciclos entre os candidatos.
+ * @return Numero de bytes libertados.
+ */
+size_t gc_contagem_processar(gc_t *gc, bool ciclos) {
+  if (!gc->contagem_ativa) {
+    return 0; // Modo de contagem inativo
+  }
+
+  if (!gc_contagem_pode_libertar(gc)) {
+    // Fica tudo para a marcaçao, que recalcula as contagens
+    gc_contagem_descartar(gc);
+    return 0;
+  }
+
+  for (size_t i = 0; i < gc->num_decrementos; i++) {
+    gc_contagem_aplicar_decremento(gc, gc->decrementos[i]);
+  }
+  gc->num_decrementos = 0;
+
+  if (ciclos || gc->num_candidatos >= GC_MAX_CANDIDATOS) {
+    gc_contagem_recolher_ciclos(gc);
+  }
+
+  return gc_varrer_libertados(gc);
+}
+
+/**
+ * @brief Esvazia os buffers de decrementos e candidatos.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_contagem_descartar(gc_t *gc) {
+  for (size_t i = 0; i < gc->num_candidatos; i++) {
+    gc->candidatos[i]->bandeiras &= (uint8_t)~GC_BANDEIRA_CANDIDATA;
+  }
+  gc->num_candidatos = 0;
+  gc->num_decrementos = 0;
+}
+
+/**
+ * @brief Compara cabeçalhos de objetos por endereço (para qsort e bsearch).
+ */
+static int gc_contagem_comparar(const void *a, const void *b) {
+  uintptr_t x = (uintptr_t) * (gc_object_t *const *)a;
+  uintptr_t y = (uintptr_t) * (gc_object_t *const *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Procura o objeto de um apontador num array ordenado de objetos.
+ */
+static gc_object_t *gc_contagem_procurar(gc_object_t **ordem, size_t n,
+                                         void *dados) {
+  if (!dados) {
+    return NULL;
+  }
+  gc_object_t *chave = GC_OBJETO(dados);
+  gc_object_t **encontrado = (gc_object_t **)bsearch(
+      &chave, ordem, n, sizeof(gc_object_t *), gc_contagem_comparar);
+  return encontrado ? *encontrado : NULL;
+}
+
+/**
+ * @brief Recalcula as contagens a partir das referencias e raizes atuais.
+ *
+ * Usa um array ordenado dos objetos para encontrar cada destino em tempo
+ * logaritmico; sem memoria para ele, procura na lista de objetos.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_contagem_recalcular(gc_t *gc) {
+  size_t n = 0;
+  for (gc_object_t *obj = gc->objetos; obj; obj = GC_PROXIMO(obj)) {
+    obj->contagem = 0;
+    obj->bandeiras &= (uint8_t) ~(GC_COR_MASCARA | GC_BANDEIRA_CANDIDATA);
+    n++;
+  }
+  gc_contagem_descartar(gc);
+
+  gc_object_t **ordem = n > 0 ? (gc_object_t **)malloc(n * sizeof(*ordem))
+                              : NULL;
+  if (ordem) {
+    size_t i = 0;
+    for (gc_object_t *obj = gc->objetos; obj; obj = GC_PROXIMO(obj)) {
+      ordem[i++] = obj;
+    }
+    qsort(ordem, n, sizeof(*ordem), gc_contagem_comparar);
+  }
+
+  for (size_t i = 0; i < gc->num_referencias + gc->num_raizes; i++) {
+    void *dados = i < gc->num_referencias
+                      ? gc_descomprimir(gc->referencias[i].para)
+                      : gc->raizes[i - gc->num_referencias];
+    gc_object_t *obj = ordem ? gc_contagem_procurar(ordem, n, dados)
+                             : gc_encontrar_objeto(gc, dados);
+    if (obj && obj->contagem != GC_CONTAGEM_MAX) {
+      obj->contagem++;
+    }
+  }
+
+  free(ordem);
+}
+
+/**
+ * @brief Ativa ou desativa o modo de contagem de referencias.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param ativar Diferente de zero para ativar.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_ativar_contagem(gc_t *gc, int ativar) {
+  if (!gc) {
+    return -1; // Erro: coletor nulo
+  }
+
+  gc->contagem_ativa = ativar != 0;
+  if (gc->contagem_ativa) {
+    gc_contagem_recalcular(gc);
+  } else {
+    gc_contagem_descartar(gc);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Aplica os decrementos adiados e recolhe ciclos de lixo.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @return Numero de bytes libertados.
+ */
+size_t gc_coletar_ciclos(gc_t *gc) {
+  if (!gc) {
+    return 0; // Erro: coletor nulo
+  }
+
+  return gc_contagem_processar(gc, true);
+}
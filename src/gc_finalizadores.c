@@ -0,0 +1,383 @@
+/**
+ * @file gc_finalizadores.c
+ * @brief Implementaçao dos finalizadores do coletor de lixo.
+ *
+ * Este arquivo contem as funçoes que associam um finalizador a um
+ * objeto e o executam depois de o objeto morrer. A coleta nao corre
+ * finalizadores: os objetos com finalizador que ficam inalcançaveis sao
+ * mantidos vivos e passam para uma fila, e o varrimento nao os liberta.
+ * Os finalizadores correm mais tarde, em lotes de GC_LOTE_FINALIZADORES,
+ * chamados pelo programa (gc_executar_finalizadores) ou por uma thread
+ * dedicada, sem aumentar a pausa da coleta.
+ *
+ * A fila e o lote em execuçao sao partilhados com a thread dedicada e
+ * protegidos por trinco_finalizar; a marcaçao trata-os como raizes, para
+ * que um objeto nao seja libertado enquanto o seu finalizador corre.
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#include "gc.h"
+#include "gc_interno.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Garante espaço para mais uma entrada num array de finalizaveis.
+ *
+ * @param array Apontador para o array.
+ * @param capacidade Apontador para a capacidade do array.
+ * @param usado Numero de entradas usadas.
+ * @return true em caso de sucesso, false se a alocaçao falhar.
+ */
+static bool gc_finalizadores_crescer(gc_finalizavel_t **array,
+                                     size_t *capacidade, size_t usado) {
+  if (usado < *capacidade) {
+    return true;
+  }
+
+  size_t nova_capacidade = *capacidade ? 2 * *capacidade : 64;
+  gc_finalizavel_t *novo = (gc_finalizavel_t *)realloc(
+      *array, nova_capacidade * sizeof(gc_finalizavel_t));
+  if (!novo) {
+    return false; // Erro: falha na alocacao
+  }
+  *array = novo;
+  *capacidade = nova_capacidade;
+  return true;
+}
+
+/**
+ * @brief Inicializa o estado dos finalizadores de um coletor novo.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_finalizadores_inicializar(gc_t *gc) {
+  gc->finalizaveis = NULL;
+  gc->num_finalizaveis = 0;
+  gc->cap_finalizaveis = 0;
+  gc->fila = NULL;
+  gc->num_fila = 0;
+  gc->cap_fila = 0;
+  gc->num_em_execucao = 0;
+  pthread_mutex_init(&gc->trinco_finalizar, NULL);
+  pthread_mutex_init(&gc->trinco_executor, NULL);
+  pthread_cond_init(&gc->sinal_finalizar, NULL);
+  gc->finalizadores_ativa = false;
+  gc->finalizadores_parar = false;
+}
+
+/**
+ * @brief Aloca um objeto com finalizador.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @param finalizador Funçao a chamar com os dados do objeto.
+ * @return Apontador para a memoria alocada, ou NULL em caso de falha.
+ */
+void *gc_alocar_com_finalizador(gc_t *gc, size_t tamanho,
+                                gc_finalizador_t finalizador) {
+  if (!gc || !finalizador) {
+    return NULL; // Erro: coletor nulo ou finalizador nulo
+  }
+
+  // Reservar a entrada antes de alocar, para nao ter de desfazer
+  if (!gc_finalizadores_crescer(&gc->finalizaveis, &gc->cap_finalizaveis,
+                                gc->num_finalizaveis)) {
+    return NULL; // Erro: falha na alocacao
+  }
+
+  void *dados = gc_alocar(gc, tamanho);
+  if (!dados) {
+    return NULL;
+  }
+
+  gc_object_t *obj = GC_OBJETO(dados);
+  obj->bandeiras |= GC_BANDEIRA_FINALIZAVEL;
+  gc->finalizaveis[gc->num_finalizaveis].obj = obj;
+  gc->finalizaveis[gc->num_finalizaveis].finalizador = finalizador;
+  gc->num_finalizaveis++;
+
+  return dados;
+}
+
+/**
+ * @brief Mantem vivos os objetos a finalizar e poe na fila os objetos com
+ * finalizador que ficaram inalcançaveis.
+ *
+ * Os objetos postos na fila sao marcados, com tudo o que referenciam,
+ * para sobreviverem ao varrimento; antes disso, as referencias fracas
+ * para objetos nao marcados sao limpas. Custa O(objetos com finalizador)
+ * quando nenhum morre; os finalizadores nao correm aqui.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_marcar_finalizaveis(gc_t *gc) {
+  pthread_mutex_lock(&gc->trinco_finalizar);
+
+  // Objetos na fila ou com o finalizador a correr funcionam como raizes
+  bool marcou = gc->num_fila > 0 || gc->num_em_execucao > 0;
+  for (size_t i = 0; i < gc->num_fila; i++) {
+    gc_marcar(gc, GC_DADOS(gc->fila[i].obj));
+  }
+  for (size_t i = 0; i < gc->num_em_execucao; i++) {
+    gc_marcar(gc, GC_DADOS(gc->em_execucao[i].obj));
+  }
+
+  // Os campos fracos para objetos que vao ser finalizados (ou que so
+  // eles alcançam) sao limpos antes de os objetos serem mantidos vivos
+  size_t i = 0;
+  while (i < gc->num_finalizaveis &&
+         gc_objeto_marcado(gc, gc->finalizaveis[i].obj)) {
+    i++;
+  }
+  if (i < gc->num_finalizaveis) {
+    if (marcou) {
+      gc_marcar_efemeros(gc); // O que a fila alcança continua vivo
+    }
+    gc_limpar_fracas_inalcancaveis(gc);
+  }
+
+  // Passar para a fila os objetos com finalizador que morreram
+  size_t novos = 0;
+  i = 0;
+  while (i < gc->num_finalizaveis) {
+    gc_object_t *obj = gc->finalizaveis[i].obj;
+    if (gc_objeto_marcado(gc, obj)) {
+      i++;
+      continue;
+    }
+
+    marcou = true;
+    gc_marcar(gc, GC_DADOS(obj));
+    if (!gc_finalizadores_crescer(&gc->fila, &gc->cap_fila, gc->num_fila)) {
+      i++; // Erro: falha na alocacao; fica vivo ate a proxima coleta
+      continue;
+    }
+    gc->fila[gc->num_fila++] = gc->finalizaveis[i];
+    gc->finalizaveis[i] = gc->finalizaveis[--gc->num_finalizaveis];
+    obj->bandeiras &= (uint8_t)~GC_BANDEIRA_FINALIZAVEL;
+    novos++;
+  }
+
+  if (novos > 0) {
+    pthread_cond_signal(&gc->sinal_finalizar);
+  }
+  pthread_mutex_unlock(&gc->trinco_finalizar);
+
+  // Objetos mantidos vivos podem ser chaves de efémeros
+  if (marcou) {
+    gc_marcar_efemeros(gc);
+  }
+}
+
+/**
+ * @brief Corre ja o finalizador de um objeto libertado fora de uma coleta.
+ *
+ * Acontece quando o programa liberta o objeto explicitamente (gc_realocar
+ * com tamanho 0). O finalizador corre antes de os dados serem libertados,
+ * para que o recurso nativo nao fique perdido.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto.
+ */
+void gc_correr_finalizador(gc_t *gc, gc_object_t *obj) {
+  obj->bandeiras &= (uint8_t)~GC_BANDEIRA_FINALIZAVEL;
+  for (size_t i = 0; i < gc->num_finalizaveis; i++) {
+    if (gc->finalizaveis[i].obj == obj) {
+      gc_finalizador_t finalizador = gc->finalizaveis[i].finalizador;
+      gc->finalizaveis[i] = gc->finalizaveis[--gc->num_finalizaveis];
+      finalizador(GC_DADOS(obj));
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Passa o finalizador de um objeto realocado para a copia.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param antigo Apontador para o cabeçalho do objeto antigo.
+ * @param novo Apontador para o cabeçalho do objeto novo.
+ */
+void gc_mover_finalizador(gc_t *gc, gc_object_t *antigo, gc_object_t *novo) {
+  for (size_t i = 0; i < gc->num_finalizaveis; i++) {
+    if (gc->finalizaveis[i].obj == antigo) {
+      gc->finalizaveis[i].obj = novo;
+      antigo->bandeiras &= (uint8_t)~GC_BANDEIRA_FINALIZAVEL;
+      novo->bandeiras |= GC_BANDEIRA_FINALIZAVEL;
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Indica se ha objetos na fila ou em finalizaçao.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @return true se algum finalizador esta por correr ou a correr.
+ */
+bool gc_finalizadores_pendentes(gc_t *gc) {
+  pthread_mutex_lock(&gc->trinco_finalizar);
+  bool pendentes = gc->num_fila > 0 || gc->num_em_execucao > 0;
+  pthread_mutex_unlock(&gc->trinco_finalizar);
+  return pendentes;
+}
+
+/**
+ * @brief Corre finalizadores da fila em lotes. O chamador detem
+ * trinco_executor.
+ *
+ * Cada lote e retirado da fila com o trinco e corre sem ele, para que
+ * uma coleta concorrente so espere pela troca de lotes.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param maximo Numero maximo de finalizadores a correr (0 para todos).
+ * @return Numero de finalizadores executados.
+ */
+static size_t gc_finalizadores_correr(gc_t *gc, size_t maximo) {
+  size_t total = 0;
+
+  while (maximo == 0 || total < maximo) {
+    pthread_mutex_lock(&gc->trinco_finalizar);
+    size_t n = gc->num_fila < GC_LOTE_FINALIZADORES ? gc->num_fila
+                                                    : GC_LOTE_FINALIZADORES;
+    if (maximo != 0 && n > maximo - total) {
+      n = maximo - total;
+    }
+    gc->num_fila -= n;
+    if (n > 0) {
+      memcpy(gc->em_execucao, gc->fila + gc->num_fila,
+             n * sizeof(gc_finalizavel_t));
+    }
+    gc->num_em_execucao = n;
+    pthread_mutex_unlock(&gc->trinco_finalizar);
+
+    if (n == 0) {
+      break; // Fila vazia
+    }
+
+    for (size_t i = 0; i < n; i++) {
+      gc->em_execucao[i].finalizador(GC_DADOS(gc->em_execucao[i].obj));
+    }
+
+    // Sem o lote nas raizes, a proxima coleta pode libertar os objetos
+    pthread_mutex_lock(&gc->trinco_finalizar);
+    gc->num_em_execucao = 0;
+    pthread_mutex_unlock(&gc->trinco_finalizar);
+
+    total += n;
+  }
+
+  return total;
+}
+
+/**
+ * @brief Corre, em lotes, finalizadores de objetos mortos.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param maximo Numero maximo de finalizadores a correr (0 para todos).
+ * @return Numero de finalizadores executados.
+ */
+size_t gc_executar_finalizadores(gc_t *gc, size_t maximo) {
+  if (!gc) {
+    return 0; // Erro: coletor nulo
+  }
+
+  if (pthread_mutex_trylock(&gc->trinco_executor) != 0) {
+    return 0; // A thread dedicada esta a correr um lote
+  }
+  size_t executados = gc_finalizadores_correr(gc, maximo);
+  pthread_mutex_unlock(&gc->trinco_executor);
+
+  return executados;
+}
+
+/**
+ * @brief Corpo da thread dedicada aos finalizadores.
+ *
+ * @param argumento Apontador para o coletor de lixo.
+ * @return NULL.
+ */
+static void *gc_finalizadores_thread(void *argumento) {
+  gc_t *gc = (gc_t *)argumento;
+
+  pthread_mutex_lock(&gc->trinco_finalizar);
+  while (!gc->finalizadores_parar) {
+    if (gc->num_fila == 0) {
+      pthread_cond_wait(&gc->sinal_finalizar, &gc->trinco_finalizar);
+      continue;
+    }
+    pthread_mutex_unlock(&gc->trinco_finalizar);
+
+    pthread_mutex_lock(&gc->trinco_executor);
+    gc_finalizadores_correr(gc, GC_LOTE_FINALIZADORES);
+    pthread_mutex_unlock(&gc->trinco_executor);
+
+    pthread_mutex_lock(&gc->trinco_finalizar);
+  }
+  pthread_mutex_unlock(&gc->trinco_finalizar);
+
+  return NULL;
+}
+
+/**
+ * @brief Inicia uma thread dedicada aos finalizadores.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_iniciar_thread_finalizadores(gc_t *gc) {
+  if (!gc) {
+    return -1; // Erro: coletor nulo
+  }
+
+  if (gc->finalizadores_ativa) {
+    return -2; // Erro: thread ja iniciada
+  }
+
+  gc->finalizadores_parar = false;
+  if (pthread_create(&gc->thread_finalizadores, NULL, gc_finalizadores_thread,
+                     gc) != 0) {
+    return -3; // Erro: nao foi possivel criar a thread
+  }
+  gc->finalizadores_ativa = true;
+
+  return 0;
+}
+
+/**
+ * @brief Para a thread de finalizadores, corre todos os finalizadores
+ * (pendentes e de objetos ainda vivos) e liberta o estado.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_finalizadores_terminar(gc_t *gc) {
+  if (gc->finalizadores_ativa) {
+    pthread_mutex_lock(&gc->trinco_finalizar);
+    gc->finalizadores_parar = true;
+    pthread_cond_signal(&gc->sinal_finalizar);
+    pthread_mutex_unlock(&gc->trinco_finalizar);
+    pthread_join(gc->thread_finalizadores, NULL);
+    gc->finalizadores_ativa = false;
+  }
+
+  // Os recursos nativos sao libertados mesmo sem o objeto ter morrido
+  pthread_mutex_lock(&gc->trinco_executor);
+  gc_finalizadores_correr(gc, 0);
+  pthread_mutex_unlock(&gc->trinco_executor);
+  for (size_t i = 0; i < gc->num_finalizaveis; i++) {
+    gc->finalizaveis[i].finalizador(GC_DADOS(gc->finalizaveis[i].obj));
+  }
+
+  free(gc->finalizaveis);
+  free(gc->fila);
+  gc->finalizaveis = NULL;
+  gc->fila = NULL;
+  gc->num_finalizaveis = 0;
+  pthread_mutex_destroy(&gc->trinco_finalizar);
+  pthread_mutex_destroy(&gc->trinco_executor);
+  pthread_cond_destroy(&gc->sinal_finalizar);
+}
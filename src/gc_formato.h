@@ -0,0 +1,142 @@
+/**
+ * @file gc_formato.h
+ * @brief Formatos binarios dos ficheiros escritos pelo coletor de lixo.
+ *
+ * Este arquivo contem as estruturas partilhadas entre a biblioteca
+ * e as ferramentas offline que leem os ficheiros gerados por ela.
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#ifndef GC_FORMATO_H
+#define GC_FORMATO_H
+
+#include <stdint.h>
+
+/**
+ * @brief Constantes do formato de snapshot.
+ *
+ * @param GC_SNAPSHOT_MAGIA Identificador no inicio do ficheiro ("GCSN").
+ * @param GC_SNAPSHOT_VERSAO Versao do formato.
+ */
+#define GC_SNAPSHOT_MAGIA 0x4e534347u
+#define GC_SNAPSHOT_VERSAO 1u
+
+/**
+ * @brief Cabecalho de um ficheiro de snapshot.
+ *
+ * @param magia Deve ser GC_SNAPSHOT_MAGIA.
+ * @param versao Versao do formato.
+ * @param num_objetos Numero de objetos escritos.
+ * @param num_raizes Numero de raizes escritas.
+ * @param num_referencias Numero de referencias escritas.
+ */
+typedef struct GCSnapshotCabecalho {
+  uint32_t magia;
+  uint32_t versao;
+  uint64_t num_objetos;
+  uint64_t num_raizes;
+  uint64_t num_referencias;
+} gc_snapshot_cabecalho_t;
+
+/**
+ * @brief Registo de um objeto no snapshot.
+ *
+ * @param endereco Endereço dos dados do objeto no processo original.
+ * @param tamanho Tamanho do objeto em bytes.
+ */
+typedef struct GCSnapshotObjeto {
+  uint64_t endereco;
+  uint64_t tamanho;
+} gc_snapshot_objeto_t;
+
+/**
+ * @brief Constantes do formato de traço de alocaçoes.
+ *
+ * @param GC_TRACO_MAGIA Identificador no inicio do ficheiro ("GCTR").
+ * @param GC_TRACO_VERSAO Versao do formato.
+ */
+#define GC_TRACO_MAGIA 0x52544347u
+#define GC_TRACO_VERSAO 1u
+
+/**
+ * @brief Cabecalho de um ficheiro de traço.
+ *
+ * Depois do cabecalho seguem-se os eventos ate ao fim do ficheiro. Cada
+ * evento e um byte com o tipo seguido dos seus argumentos, codificados
+ * como inteiros de tamanho variavel (LEB128). Os endereços sao escritos
+ * como diferença (zigzag) para o endereço anterior do traço.
+ *
+ * @param magia Deve ser GC_TRACO_MAGIA.
+ * @param versao Versao do formato.
+ * @param tamanho_heap Tamanho da heap do coletor gravado.
+ */
+typedef struct GCTracoCabecalho {
+  uint32_t magia;
+  uint32_t versao;
+  uint64_t tamanho_heap;
+} gc_traco_cabecalho_t;
+
+/**
+ * @brief Tipos de evento do traço e respetivos argumentos.
+ */
+typedef enum GCTracoEvento {
+  GC_TRACO_ALOCAR = 1,       /**< endereco, tamanho */
+  GC_TRACO_REALOCAR = 2,     /**< endereco antigo, endereco novo, tamanho */
+  GC_TRACO_RAIZ = 3,         /**< endereco */
+  GC_TRACO_REMOVER_RAIZ = 4, /**< endereco */
+  GC_TRACO_REFERENCIA = 5,   /**< endereco de, endereco para */
+  GC_TRACO_COLETAR = 6,      /**< sem argumentos */
+  GC_TRACO_REMOVER_REFERENCIA = 7 /**< endereco de, endereco para */
+} gc_traco_evento_t;
+
+/**
+ * @brief Constantes do formato de imagem do heap.
+ *
+ * @param GC_IMAGEM_MAGIA Identificador no inicio do ficheiro ("GCIM").
+ * @param GC_IMAGEM_VERSAO Versao do formato.
+ * @param GC_IMAGEM_AREA Deslocamento da area de objetos no ficheiro
+ * (multiplo do tamanho de pagina, para poder ser mapeada com mmap).
+ */
+#define GC_IMAGEM_MAGIA 0x4d494347u
+#define GC_IMAGEM_VERSAO 1u
+#define GC_IMAGEM_AREA (64 * 1024)
+
+/**
+ * @brief Cabecalho de um ficheiro de imagem do heap.
+ *
+ * A area de objetos comeca em GC_IMAGEM_AREA e guarda os objetos
+ * contiguos, cada um com o cabeçalho do coletor seguido dos dados, tal
+ * como ficam em memoria. Os apontadores entre objetos (cabeçalhos e
+ * campos com referencia registada) assumem que a area fica em base.
+ * Depois da area seguem-se as raizes e os pares (de, para) das
+ * referencias, como deslocamentos de 64 bits dos dados na area.
+ *
+ * @param magia Deve ser GC_IMAGEM_MAGIA.
+ * @param versao Versao do formato.
+ * @param cabecalho_objeto Tamanho do cabeçalho de objeto de quem gravou.
+ * @param comprimido 1 se gravada com referencias comprimidas, 0 se nao.
+ * @param base Endereço preferido da area de objetos.
+ * @param tamanho_heap Tamanho da heap do coletor gravado.
+ * @param memoria_usada Soma dos tamanhos dos objetos.
+ * @param num_objetos Numero de objetos na area.
+ * @param tamanho_area Tamanho da area de objetos em bytes.
+ * @param num_raizes Numero de raizes escritas.
+ * @param num_referencias Numero de referencias escritas.
+ */
+typedef struct GCImagemCabecalho {
+  uint32_t magia;
+  uint32_t versao;
+  uint32_t cabecalho_objeto;
+  uint32_t comprimido;
+  uint64_t base;
+  uint64_t tamanho_heap;
+  uint64_t memoria_usada;
+  uint64_t num_objetos;
+  uint64_t tamanho_area;
+  uint64_t num_raizes;
+  uint64_t num_referencias;
+} gc_imagem_cabecalho_t;
+
+#endif // !GC_FORMATO_H
@@ -0,0 +1,306 @@
+/**
+ * @file gc_fracas.c
+ * @brief Implementaçao de referencias fracas e efémeros.
+ *
+ * Este arquivo contem as funçoes para registar referencias que nao
+ * mantem objetos vivos: referencias fracas, limpas pelo coletor quando
+ * o objeto morre, e efémeros, em que o valor so vive enquanto a chave
+ * for alcançavel.
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#include "gc.h"
+#include "gc_interno.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @brief Regista uma referencia fraca.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param campo Endereço do apontador que guarda a referencia fraca.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_registar_referencia_fraca(gc_t *gc, void **campo) {
+  if (!gc || !campo) {
+    return -1; // Erro: coletor nulo ou campo nulo
+  }
+
+  // Verifica se já atingimos o limite de referencias fracas
+  if (gc->num_fracas >= GC_MAX_FRACAS) {
+    return -2; // Erro: limite de referencias fracas atingido
+  }
+
+  gc->fracas[gc->num_fracas++] = campo;
+  gc_regiao_registar(gc, campo);
+
+  return 0;
+}
+
+/**
+ * @brief Remove uma referencia fraca registada.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param campo Endereço do apontador registado.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_remover_referencia_fraca(gc_t *gc, void **campo) {
+  if (!gc || !campo) {
+    return -1; // Erro: coletor nulo ou campo nulo
+  }
+
+  for (size_t i = 0; i < gc->num_fracas; i++) {
+    if (gc->fracas[i] == campo) {
+      gc->fracas[i] = gc->fracas[--gc->num_fracas];
+      return 0; // Sucesso
+    }
+  }
+
+  return -2; // Erro: referencia fraca nao encontrada
+}
+
+/**
+ * @brief Regista um efémero, substituindo o valor se a chave ja existir.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param chave Apontador para o objeto chave.
+ * @param valor Apontador para o objeto valor.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_registar_efemero(gc_t *gc, void *chave, void *valor) {
+  if (!gc || !chave || !valor) {
+    return -1; // Erro: um dos apontadores está nulo
+  }
+
+  // Substituir o valor se a chave ja existir
+  for (size_t i = 0; i < gc->num_efemeros; i++) {
+    if (gc->efemeros[i].chave == chave) {
+      gc->efemeros[i].valor = valor;
+      gc_regiao_registar(gc, valor);
+      return 0;
+    }
+  }
+
+  // Verifica se já atingimos o limite de efémeros
+  if (gc->num_efemeros >= GC_MAX_EFEMEROS) {
+    return -2; // Erro: limite de efémeros atingido
+  }
+
+  gc->efemeros[gc->num_efemeros].chave = chave;
+  gc->efemeros[gc->num_efemeros].valor = valor;
+  gc->num_efemeros++;
+  gc_regiao_registar(gc, chave);
+  gc_regiao_registar(gc, valor);
+
+  return 0;
+}
+
+/**
+ * @brief Obtem o valor associado a uma chave na tabela de efémeros.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param chave Apontador para o objeto chave.
+ * @return Apontador para o valor, ou NULL se a chave nao existir.
+ */
+void *gc_obter_efemero(gc_t *gc, void *chave) {
+  if (!gc || !chave) {
+    return NULL; // Erro: coletor nulo ou chave nula
+  }
+
+  for (size_t i = 0; i < gc->num_efemeros; i++) {
+    if (gc->efemeros[i].chave == chave) {
+      return gc->efemeros[i].valor;
+    }
+  }
+
+  return NULL; // Chave nao encontrada
+}
+
+/**
+ * @brief Remove a entrada de uma chave da tabela de efémeros.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param chave Apontador para o objeto chave.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_remover_efemero(gc_t *gc, void *chave) {
+  if (!gc || !chave) {
+    return -1; // Erro: coletor nulo ou chave nula
+  }
+
+  for (size_t i = 0; i < gc->num_efemeros; i++) {
+    if (gc->efemeros[i].chave == chave) {
+      gc->efemeros[i] = gc->efemeros[--gc->num_efemeros];
+      return 0; // Sucesso
+    }
+  }
+
+  return -2; // Erro: chave nao encontrada
+}
+
+/**
+ * @brief Limpa referencias fracas e efémeros que envolvem um objeto libertado.
+ *
+ * Os campos que apontam para o objeto passam a NULL. Os campos que vivem
+ * dentro do proprio objeto deixam de estar registados, para que nao sejam
+ * escritos depois de a memoria ser libertada.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param dados Apontador para os dados do objeto libertado.
+ * @param tamanho Tamanho do objeto em bytes.
+ */
+void gc_remover_fracas(gc_t *gc, void *dados, size_t tamanho) {
+  if (!gc || !dados) {
+    return; // Erro: coletor nulo ou objeto nulo
+  }
+
+  uintptr_t inicio = (uintptr_t)dados;
+  uintptr_t fim = inicio + tamanho;
+
+  size_t i = 0;
+  while (i < gc->num_fracas) {
+    uintptr_t campo = (uintptr_t)gc->fracas[i];
+    if (campo >= inicio && campo < fim) {
+      // Campo dentro do objeto libertado: remover o registo
+      gc->fracas[i] = gc->fracas[--gc->num_fracas];
+      continue;
+    }
+    if (*gc->fracas[i] == dados) {
+      *gc->fracas[i] = NULL;
+    }
+    i++;
+  }
+
+  i = 0;
+  while (i < gc->num_efemeros) {
+    if (gc->efemeros[i].chave == dados || gc->efemeros[i].valor == dados) {
+      gc->efemeros[i] = gc->efemeros[--gc->num_efemeros];
+    } else {
+      i++;
+    }
+  }
+}
+
+/**
+ * @brief Atualiza referencias fracas e efémeros de um objeto realocado.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param antigo Apontador para os dados antigos.
+ * @param novo Apontador para os dados novos.
+ * @param tamanho Numero de bytes copiados para o novo bloco.
+ */
+void gc_atualizar_fracas(gc_t *gc, void *antigo, void *novo, size_t tamanho) {
+  if (!gc || !antigo || !novo) {
+    return; // Erro: um dos apontadores está nulo
+  }
+
+  uintptr_t inicio = (uintptr_t)antigo;
+  uintptr_t fim = inicio + tamanho;
+
+  for (size_t i = 0; i < gc->num_fracas; i++) {
+    uintptr_t campo = (uintptr_t)gc->fracas[i];
+    if (campo >= inicio && campo < fim) {
+      // O campo foi copiado com o objeto
+      gc->fracas[i] = (void **)((char *)novo + (campo - inicio));
+    }
+    if (*gc->fracas[i] == antigo) {
+      *gc->fracas[i] = novo;
+    }
+  }
+
+  for (size_t i = 0; i < gc->num_efemeros; i++) {
+    if (gc->efemeros[i].chave == antigo) {
+      gc->efemeros[i].chave = novo;
+    }
+    if (gc->efemeros[i].valor == antigo) {
+      gc->efemeros[i].valor = novo;
+    }
+  }
+}
+
+/**
+ * @brief Campo fraco e o objeto para que apontava no inicio da limpeza.
+ */
+typedef struct {
+  uintptr_t alvo;
+  void **campo;
+} gc_fraca_alvo_t;
+
+/**
+ * @brief Compara dois campos fracos pelo objeto para que apontam.
+ *
+ * @param a Apontador para o primeiro campo.
+ * @param b Apontador para o segundo campo.
+ * @return Negativo, zero ou positivo, como em qsort.
+ */
+static int gc_fracas_comparar(const void *a, const void *b) {
+  uintptr_t alvo_a = ((const gc_fraca_alvo_t *)a)->alvo;
+  uintptr_t alvo_b = ((const gc_fraca_alvo_t *)b)->alvo;
+  return (alvo_a > alvo_b) - (alvo_a < alvo_b);
+}
+
+/**
+ * @brief Limpa as referencias fracas para objetos ainda nao marcados.
+ *
+ * Chamada antes de os objetos com finalizador serem mantidos vivos, para
+ * que nenhum campo fraco devolva um objeto ja entregue ao finalizador
+ * (nem algo que so ele alcança). Os campos sao ordenados pelo alvo e a
+ * lista de objetos e percorrida uma vez.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_limpar_fracas_inalcancaveis(gc_t *gc) {
+  if (!gc || gc->num_fracas == 0) {
+    return; // Sem referencias fracas
+  }
+
+  gc_fraca_alvo_t *campos =
+      (gc_fraca_alvo_t *)malloc(gc->num_fracas * sizeof(gc_fraca_alvo_t));
+  if (!campos) {
+    // Sem memoria para ordenar: procurar o alvo de cada campo
+    for (size_t i = 0; i < gc->num_fracas; i++) {
+      gc_object_t *alvo = gc_encontrar_objeto(gc, *gc->fracas[i]);
+      if (alvo && !gc_objeto_marcado(gc, alvo)) {
+        *gc->fracas[i] = NULL;
+      }
+    }
+    return;
+  }
+
+  size_t num_campos = 0;
+  for (size_t i = 0; i < gc->num_fracas; i++) {
+    if (*gc->fracas[i]) {
+      campos[num_campos].alvo = (uintptr_t)*gc->fracas[i];
+      campos[num_campos].campo = gc->fracas[i];
+      num_campos++;
+    }
+  }
+  qsort(campos, num_campos, sizeof(gc_fraca_alvo_t), gc_fracas_comparar);
+
+  for (gc_object_t *obj = gc->objetos; obj && num_campos > 0;
+       obj = GC_PROXIMO(obj)) {
+    if (gc_objeto_marcado(gc, obj)) {
+      continue;
+    }
+
+    // Primeiro campo cujo alvo nao e menor do que os dados do objeto
+    uintptr_t dados = (uintptr_t)GC_DADOS(obj);
+    size_t inicio = 0;
+    size_t fim = num_campos;
+    while (inicio < fim) {
+      size_t meio = inicio + (fim - inicio) / 2;
+      if (campos[meio].alvo < dados) {
+        inicio = meio + 1;
+      } else {
+        fim = meio;
+      }
+    }
+    for (; inicio < num_campos && campos[inicio].alvo == dados; inicio++) {
+      *campos[inicio].campo = NULL;
+    }
+  }
+
+  free(campos);
+}
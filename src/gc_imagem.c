@@ -0,0 +1,584 @@
+/**
+ * @file gc_imagem.c
+ * @brief Imagens persistentes do heap do coletor de lixo.
+ *
+ * Este arquivo contem as funçoes que gravam o heap (objetos, raizes e
+ * referencias) num ficheiro e o voltam a carregar noutro processo. Ao
+ * contrario do snapshot, a imagem guarda o conteudo dos objetos ja no
+ * formato de memoria do coletor: carregar uma imagem e mapear o
+ * ficheiro em copia-na-escrita, sem copiar nem alocar objeto a objeto.
+ *
+ * Os objetos sao gravados contiguos, com os apontadores entre eles
+ * calculados para um endereço preferido (GC_IMAGEM_BASE). Se o ficheiro
+ * ficar mapeado nesse endereço nao ha nada a corrigir: a carga so le os
+ * cabeçalhos, para validar a area e os deslocamentos das raizes e
+ * referencias. Caso contrario, a lista de objetos e religada e os campos
+ * com referencia registada sao corrigidos, tal como na promoçao de
+ * regioes; as paginas tocadas passam a ser copias privadas do processo.
+ * Os bits de marcaçao dos objetos da imagem ficam fora dela
+ * (gc_imagem_t.marcas), para que as coletas nao copiem as paginas.
+ *
+ * Formato do ficheiro (inteiros na ordem de bytes da maquina):
+ *   - cabecalho gc_imagem_cabecalho_t;
+ *   - em GC_IMAGEM_AREA, tamanho_area bytes de objetos;
+ *   - num_raizes deslocamentos de 64 bits;
+ *   - num_referencias pares de deslocamentos de 64 bits (de, para).
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "gc.h"
+#include "gc_formato.h"
+#include "gc_interno.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Endereço preferido da area de objetos de uma imagem.
+ */
+#define GC_IMAGEM_BASE ((uint64_t)0x580000000000)
+
+/**
+ * @brief Bytes de bits (um por GC_ALINHAMENTO bytes) para uma area.
+ */
+#define GC_IMAGEM_TAMANHO_MARCAS(tamanho_area)                                 \
+  ((size_t)(((tamanho_area) / GC_ALINHAMENTO + 7) / 8))
+
+/**
+ * @brief Par endereço/deslocamento usado para traduzir apontadores.
+ *
+ * @param endereco Apontador para os dados do objeto no heap.
+ * @param deslocamento Deslocamento dos dados do objeto na area.
+ */
+typedef struct GCImagemEntrada {
+  uintptr_t endereco;
+  uint64_t deslocamento;
+} gc_imagem_entrada_t;
+
+/**
+ * @brief Referencia a gravar, com o endereço antigo do destino.
+ *
+ * @param de Deslocamento dos dados do objeto de origem.
+ * @param para Deslocamento dos dados do objeto de destino.
+ * @param antigo Endereço do destino no heap (valor dos campos a corrigir).
+ */
+typedef struct GCImagemAresta {
+  uint64_t de;
+  uint64_t para;
+  uintptr_t antigo;
+} gc_imagem_aresta_t;
+
+/**
+ * @brief Compara duas entradas pelo endereço (para qsort/bsearch).
+ */
+static int gc_imagem_comparar(const void *a, const void *b) {
+  uintptr_t ea = ((const gc_imagem_entrada_t *)a)->endereco;
+  uintptr_t eb = ((const gc_imagem_entrada_t *)b)->endereco;
+  return (ea > eb) - (ea < eb);
+}
+
+/**
+ * @brief Compara duas arestas pelo deslocamento de origem (para qsort).
+ */
+static int gc_imagem_comparar_arestas(const void *a, const void *b) {
+  uint64_t da = ((const gc_imagem_aresta_t *)a)->de;
+  uint64_t db = ((const gc_imagem_aresta_t *)b)->de;
+  return (da > db) - (da < db);
+}
+
+/**
+ * @brief Procura o deslocamento de um objeto a partir dos seus dados.
+ *
+ * @param indice Array de entradas ordenado por endereço.
+ * @param num_objetos Numero de entradas no array.
+ * @param dados Apontador para os dados do objeto.
+ * @param deslocamento Apontador onde sera guardado o deslocamento.
+ * @return true se o apontador corresponde a um objeto, false caso contrario.
+ */
+static bool gc_imagem_procurar(const gc_imagem_entrada_t *indice,
+                               size_t num_objetos, void *dados,
+                               uint64_t *deslocamento) {
+  if (!indice) {
+    return false; // Heap vazio
+  }
+
+  gc_imagem_entrada_t chave = {(uintptr_t)dados, 0};
+  const gc_imagem_entrada_t *entrada = bsearch(
+      &chave, indice, num_objetos, sizeof(*indice), gc_imagem_comparar);
+  if (!entrada) {
+    return false;
+  }
+  *deslocamento = entrada->deslocamento;
+  return true;
+}
+
+/**
+ * @brief Substitui, nos campos de um objeto, um apontador por outro.
+ *
+ * @param objeto Apontador para os dados do objeto.
+ * @param tamanho Tamanho do objeto em bytes.
+ * @param antigo Valor a procurar.
+ * @param novo Valor a escrever.
+ */
+static void gc_imagem_corrigir_campos(void *objeto, size_t tamanho,
+                                      uintptr_t antigo, uintptr_t novo) {
+  uintptr_t *campos = (uintptr_t *)objeto;
+  for (size_t i = 0; i < tamanho / sizeof(uintptr_t); i++) {
+    if (campos[i] == antigo) {
+      campos[i] = novo;
+    }
+  }
+}
+
+/**
+ * @brief Grava o heap, as raizes e as referencias numa imagem.
+ *
+ * Todos os objetos da lista sao gravados, alcançaveis ou nao. Raizes
+ * e referencias que nao correspondem a objetos geridos sao ignoradas.
+ * Nos dados gravados, os campos que guardam o destino de uma referencia
+ * registada passam a apontar para a copia na imagem; outros apontadores
+ * sao gravados sem alteraçoes.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param caminho Caminho do ficheiro a criar.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_salvar_imagem(gc_t *gc, const char *caminho) {
+  if (!gc || !caminho) {
+    return -1; // Erro: coletor nulo ou caminho nulo
+  }
+
+  if (gc->num_tipados > 0) {
+    return -2; // Erro: ids de tipo e campos gc_ptr nao sao relocaveis
+  }
+
+  // Contar objetos e calcular o maior
+  size_t num_objetos = 0;
+  size_t maior = 0;
+  for (gc_object_t *obj = gc->objetos; obj; obj = GC_PROXIMO(obj)) {
+    num_objetos++;
+    if (obj->tamanho > maior) {
+      maior = obj->tamanho;
+    }
+  }
+
+  gc_imagem_entrada_t *indice = NULL;
+  gc_imagem_aresta_t *arestas = NULL;
+  char *copia = NULL;
+  if (num_objetos > 0) {
+    indice = (gc_imagem_entrada_t *)malloc(num_objetos * sizeof(*indice));
+    copia = (char *)malloc(GC_ALINHAR(maior) + GC_CABECALHO_OBJETO);
+  }
+  if (gc->num_referencias > 0) {
+    arestas = (gc_imagem_aresta_t *)malloc(gc->num_referencias *
+                                           sizeof(*arestas));
+  }
+  if ((num_objetos > 0 && (!indice || !copia)) ||
+      (gc->num_referencias > 0 && !arestas)) {
+    free(indice);
+    free(arestas);
+    free(copia);
+    return -3; // Erro: falha na alocacao
+  }
+
+  // Atribuir deslocamentos pela ordem da lista
+  gc_imagem_cabecalho_t cabecalho = {GC_IMAGEM_MAGIA,
+                                     GC_IMAGEM_VERSAO,
+                                     (uint32_t)GC_CABECALHO_OBJETO,
+#ifdef GC_REFERENCIAS_COMPRIMIDAS
+                                     1,
+#else
+                                     0,
+#endif
+                                     GC_IMAGEM_BASE,
+                                     (uint64_t)gc->tamanho_heap,
+                                     0,
+                                     (uint64_t)num_objetos,
+                                     0,
+                                     0,
+                                     0};
+  size_t i = 0;
+  for (gc_object_t *obj = gc->objetos; obj; obj = GC_PROXIMO(obj)) {
+    indice[i].endereco = (uintptr_t)GC_DADOS(obj);
+    indice[i].deslocamento = cabecalho.tamanho_area + GC_CABECALHO_OBJETO;
+    cabecalho.tamanho_area += GC_CABECALHO_OBJETO + GC_ALINHAR(obj->tamanho);
+    cabecalho.memoria_usada += obj->tamanho;
+    i++;
+  }
+  if (num_objetos > 0) {
+    qsort(indice, num_objetos, sizeof(*indice), gc_imagem_comparar);
+  }
+
+  // Traduzir as referencias e ordena-las pela origem
+  size_t num_arestas = 0;
+  for (i = 0; i < gc->num_referencias; i++) {
+    gc_imagem_aresta_t *aresta = &arestas[num_arestas];
+    aresta->antigo = (uintptr_t)gc_descomprimir(gc->referencias[i].para);
+    if (gc_imagem_procurar(indice, num_objetos,
+                           gc_descomprimir(gc->referencias[i].de),
+                           &aresta->de) &&
+        gc_imagem_procurar(indice, num_objetos, (void *)aresta->antigo,
+                           &aresta->para)) {
+      num_arestas++;
+    }
+  }
+  if (num_arestas > 0) {
+    qsort(arestas, num_arestas, sizeof(*arestas), gc_imagem_comparar_arestas);
+  }
+  cabecalho.num_referencias = num_arestas;
+
+  FILE *ficheiro = fopen(caminho, "wb");
+  if (!ficheiro) {
+    free(indice);
+    free(arestas);
+    free(copia);
+    return -4; // Erro: nao foi possivel criar o ficheiro
+  }
+
+  int erro = fwrite(&cabecalho, sizeof(cabecalho), 1, ficheiro) != 1 ||
+             fseek(ficheiro, GC_IMAGEM_AREA, SEEK_SET) != 0;
+
+  // Escrever os objetos, ja ligados e com os campos corrigidos
+  uint64_t deslocamento = 0;
+  size_t proxima_aresta = 0;
+  for (gc_object_t *obj = gc->objetos; obj && !erro; obj = GC_PROXIMO(obj)) {
+    size_t tamanho = GC_ALINHAR(obj->tamanho);
+    uint64_t dados = deslocamento + GC_CABECALHO_OBJETO;
+    deslocamento = dados + tamanho;
+
+    gc_object_t *cabecalho_obj = (gc_object_t *)copia;
+    memset(copia, 0, GC_CABECALHO_OBJETO);
+    cabecalho_obj->tamanho = obj->tamanho;
+    cabecalho_obj->bandeiras = GC_BANDEIRA_IMAGEM;
+#ifndef GC_REFERENCIAS_COMPRIMIDAS
+    // A lista so fica valida sem correçoes no endereço preferido
+    if (GC_PROXIMO(obj)) {
+      cabecalho_obj->proximo =
+          (gc_ref_t)(uintptr_t)(GC_IMAGEM_BASE + deslocamento);
+    }
+#endif
+    erro = fwrite(copia, GC_CABECALHO_OBJETO, 1, ficheiro) != 1;
+
+    memcpy(copia, GC_DADOS(obj), obj->tamanho);
+    memset(copia + obj->tamanho, 0, tamanho - obj->tamanho);
+    while (proxima_aresta < num_arestas &&
+           arestas[proxima_aresta].de == dados) {
+      gc_imagem_corrigir_campos(
+          copia, obj->tamanho, arestas[proxima_aresta].antigo,
+          (uintptr_t)(GC_IMAGEM_BASE + arestas[proxima_aresta].para));
+      proxima_aresta++;
+    }
+    if (!erro && tamanho > 0) {
+      erro = fwrite(copia, tamanho, 1, ficheiro) != 1;
+    }
+  }
+
+  // Escrever as raizes
+  for (i = 0; i < gc->num_raizes && !erro; i++) {
+    uint64_t raiz;
+    if (gc_imagem_procurar(indice, num_objetos, gc->raizes[i], &raiz)) {
+      erro = fwrite(&raiz, sizeof(raiz), 1, ficheiro) != 1;
+      cabecalho.num_raizes++;
+    }
+  }
+
+  // Escrever as referencias
+  for (i = 0; i < num_arestas && !erro; i++) {
+    uint64_t aresta[2] = {arestas[i].de, arestas[i].para};
+    erro = fwrite(aresta, sizeof(aresta), 1, ficheiro) != 1;
+  }
+
+  // Reescrever o cabecalho com os contadores finais
+  if (!erro) {
+    erro = fseek(ficheiro, 0, SEEK_SET) != 0 ||
+           fwrite(&cabecalho, sizeof(cabecalho), 1, ficheiro) != 1;
+  }
+
+  erro |= fclose(ficheiro) != 0;
+  free(indice);
+  free(arestas);
+  free(copia);
+
+  return erro ? -5 : 0; // Erro: falha na escrita
+}
+
+/**
+ * @brief Percorre os objetos de uma imagem mapeada, validando-os.
+ *
+ * Regista em inicios o deslocamento de cada cabeçalho (um bit por
+ * GC_ALINHAMENTO bytes). Fora da base, ou com referencias comprimidas,
+ * religa a lista; caso contrario so verifica a lista gravada, sem
+ * escrever nas paginas.
+ *
+ * @param area Inicio da area de objetos.
+ * @param tamanho_area Tamanho da area em bytes.
+ * @param ligar Se a lista deve ser religada.
+ * @param inicios Bits dos cabeçalhos, a zeros a entrada.
+ * @return Primeiro objeto da lista, ou NULL se a area estiver corrompida.
+ */
+static gc_object_t *gc_imagem_religar(char *area, uint64_t tamanho_area,
+                                      bool ligar, uint8_t *inicios) {
+  uint64_t deslocamento = 0;
+  gc_object_t *anterior = NULL;
+  while (deslocamento < tamanho_area) {
+    gc_object_t *obj = (gc_object_t *)(area + deslocamento);
+    if (tamanho_area - deslocamento < GC_CABECALHO_OBJETO ||
+        GC_ALINHAR(obj->tamanho) >
+            tamanho_area - deslocamento - GC_CABECALHO_OBJETO ||
+        obj->bandeiras != GC_BANDEIRA_IMAGEM) {
+      return NULL; // Erro: objeto ultrapassa o fim da area
+    }
+    if (ligar) {
+      obj->proximo = gc_comprimir(NULL);
+      if (anterior) {
+        anterior->proximo = gc_comprimir(obj);
+      }
+    } else if (anterior && GC_PROXIMO(anterior) != obj) {
+      return NULL; // Erro: lista gravada nao segue a area
+    }
+    uint64_t granulo = deslocamento / GC_ALINHAMENTO;
+    inicios[granulo / 8] |= (uint8_t)(1u << (granulo % 8));
+    anterior = obj;
+    deslocamento += GC_CABECALHO_OBJETO + GC_ALINHAR(obj->tamanho);
+  }
+  if (!ligar && anterior && GC_PROXIMO(anterior)) {
+    return NULL; // Erro: lista gravada continua depois do fim da area
+  }
+  return (gc_object_t *)area;
+}
+
+/**
+ * @brief Verifica se um deslocamento aponta para os dados de um objeto.
+ *
+ * @param inicios Bits dos cabeçalhos preenchidos por gc_imagem_religar.
+ * @param tamanho_area Tamanho da area em bytes.
+ * @param dados Deslocamento gravado no ficheiro.
+ * @return true se houver um objeto com os dados nesse deslocamento.
+ */
+static bool gc_imagem_deslocamento_valido(const uint8_t *inicios,
+                                          uint64_t tamanho_area,
+                                          uint64_t dados) {
+  if (!inicios || dados < GC_CABECALHO_OBJETO ||
+      dados - GC_CABECALHO_OBJETO >= tamanho_area ||
+      (dados - GC_CABECALHO_OBJETO) % GC_ALINHAMENTO != 0) {
+    return false; // Fora da area ou desalinhado
+  }
+  uint64_t granulo = (dados - GC_CABECALHO_OBJETO) / GC_ALINHAMENTO;
+  return (inicios[granulo / 8] >> (granulo % 8)) & 1;
+}
+
+/**
+ * @brief Encontra a imagem que contem um objeto.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto.
+ * @return Apontador para a imagem, ou NULL se nenhuma o contem.
+ */
+static gc_imagem_t *gc_imagem_do_objeto(gc_t *gc, const gc_object_t *obj) {
+  for (gc_imagem_t *imagem = gc->imagens; imagem; imagem = imagem->proxima) {
+    uintptr_t inicio = (uintptr_t)imagem->inicio;
+    if ((uintptr_t)obj >= inicio && (uintptr_t)obj - inicio < imagem->tamanho) {
+      return imagem;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Indica se um objeto de uma imagem esta marcado.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho (com GC_BANDEIRA_IMAGEM).
+ * @return true se o objeto estiver marcado.
+ */
+bool gc_imagem_marcado(gc_t *gc, const gc_object_t *obj) {
+  gc_imagem_t *imagem = gc_imagem_do_objeto(gc, obj);
+  if (!imagem) {
+    return false; // Erro: objeto fora das imagens
+  }
+  size_t granulo =
+      (size_t)((const char *)obj - (char *)imagem->inicio) / GC_ALINHAMENTO;
+  return (imagem->marcas[granulo / 8] >> (granulo % 8)) & 1;
+}
+
+/**
+ * @brief Marca um objeto de uma imagem.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho (com GC_BANDEIRA_IMAGEM).
+ */
+void gc_imagem_marcar(gc_t *gc, const gc_object_t *obj) {
+  gc_imagem_t *imagem = gc_imagem_do_objeto(gc, obj);
+  if (!imagem) {
+    return; // Erro: objeto fora das imagens
+  }
+  size_t granulo =
+      (size_t)((const char *)obj - (char *)imagem->inicio) / GC_ALINHAMENTO;
+  imagem->marcas[granulo / 8] |= (uint8_t)(1u << (granulo % 8));
+}
+
+/**
+ * @brief Desmarca todos os objetos das imagens do coletor.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_imagem_desmarcar(gc_t *gc) {
+  for (gc_imagem_t *imagem = gc->imagens; imagem; imagem = imagem->proxima) {
+    memset(imagem->marcas, 0, GC_IMAGEM_TAMANHO_MARCAS(imagem->tamanho));
+  }
+}
+
+/**
+ * @brief Cria um coletor a partir de uma imagem gravada por
+ * gc_salvar_imagem.
+ *
+ * A area de objetos e mapeada em copia-na-escrita: o ficheiro nao e
+ * alterado e as paginas so sao lidas quando usadas. A imagem tem de ter
+ * sido gravada por uma biblioteca com o mesmo formato de objetos
+ * (incluindo o modo de referencias comprimidas).
+ *
+ * @param caminho Caminho do ficheiro de imagem.
+ * @return Apontador para o novo coletor, ou NULL em caso de erro.
+ */
+gc_t *gc_carregar_imagem(const char *caminho) {
+  if (!caminho) {
+    return NULL; // Erro: caminho nulo
+  }
+
+  int fd = open(caminho, O_RDONLY);
+  if (fd < 0) {
+    return NULL; // Erro: nao foi possivel abrir o ficheiro
+  }
+
+  // Validar o cabecalho e o tamanho do ficheiro
+  gc_imagem_cabecalho_t cabecalho;
+  struct stat estado;
+#ifdef GC_REFERENCIAS_COMPRIMIDAS
+  uint32_t comprimido = 1;
+#else
+  uint32_t comprimido = 0;
+#endif
+  if (pread(fd, &cabecalho, sizeof(cabecalho), 0) !=
+          (ssize_t)sizeof(cabecalho) ||
+      fstat(fd, &estado) != 0 || cabecalho.magia != GC_IMAGEM_MAGIA ||
+      cabecalho.versao != GC_IMAGEM_VERSAO ||
+      cabecalho.cabecalho_objeto != GC_CABECALHO_OBJETO ||
+      cabecalho.comprimido != comprimido ||
+      cabecalho.num_raizes > GC_MAX_RAIZES ||
+      cabecalho.num_referencias > GC_MAX_REFERENCIAS ||
+      cabecalho.tamanho_area > (uint64_t)estado.st_size ||
+      (uint64_t)estado.st_size - cabecalho.tamanho_area <
+          GC_IMAGEM_AREA + (cabecalho.num_raizes +
+                            2 * cabecalho.num_referencias) *
+                               sizeof(uint64_t)) {
+    close(fd);
+    return NULL; // Erro: ficheiro invalido ou de outro formato de objetos
+  }
+
+  // Ler raizes e referencias, que ficam depois da area de objetos
+  size_t num_entradas =
+      cabecalho.num_raizes + 2 * cabecalho.num_referencias;
+  uint64_t *entradas = NULL;
+  if (num_entradas > 0) {
+    entradas = (uint64_t *)malloc(num_entradas * sizeof(uint64_t));
+    if (!entradas ||
+        pread(fd, entradas, num_entradas * sizeof(uint64_t),
+              (off_t)(GC_IMAGEM_AREA + cabecalho.tamanho_area)) !=
+            (ssize_t)(num_entradas * sizeof(uint64_t))) {
+      free(entradas);
+      close(fd);
+      return NULL; // Erro: falha na alocacao ou na leitura
+    }
+  }
+
+  gc_t *gc = gc_inicializar(cabecalho.tamanho_heap);
+  if (!gc) {
+    free(entradas);
+    close(fd);
+    return NULL; // Erro: falha na alocacao
+  }
+
+  char *area = NULL;
+  uint8_t *inicios = NULL;
+  if (cabecalho.tamanho_area > 0) {
+    gc_imagem_t *imagem = (gc_imagem_t *)malloc(sizeof(gc_imagem_t));
+    inicios = (uint8_t *)calloc(
+        GC_IMAGEM_TAMANHO_MARCAS(cabecalho.tamanho_area), 1);
+    if (imagem && inicios) {
+      area = (char *)gc_pool_mapear_ficheiro(
+          fd, cabecalho.tamanho_area, GC_IMAGEM_AREA,
+          (void *)(uintptr_t)cabecalho.base);
+    }
+    if (!area) {
+      free(imagem);
+      free(inicios);
+      free(entradas);
+      close(fd);
+      gc_finalizar(gc);
+      return NULL; // Erro: falha na alocacao ou no mmap
+    }
+    imagem->inicio = area;
+    imagem->tamanho = cabecalho.tamanho_area;
+    imagem->marcas = inicios; // Bits dos cabeçalhos ate ao fim da carga
+    imagem->proxima = gc->imagens;
+    gc->imagens = imagem;
+  }
+  close(fd); // O mapeamento mantem o ficheiro aberto
+
+  // Fora da base, religar a lista (com referencias comprimidas nunca
+  // vem ligada, porque depende da base da reserva)
+  bool relocar = area && (uintptr_t)area != cabecalho.base;
+  if (area) {
+    gc->objetos = gc_imagem_religar(area, cabecalho.tamanho_area,
+                                    relocar || comprimido, inicios);
+    if (!gc->objetos) {
+      free(entradas);
+      gc_finalizar(gc);
+      return NULL; // Erro: area de objetos corrompida
+    }
+  }
+  gc->memoria_usada = cabecalho.memoria_usada;
+
+  // Registar referencias e corrigir os campos que as guardam
+  uint64_t *pares = entradas ? entradas + cabecalho.num_raizes : NULL;
+  for (size_t i = 0; i < cabecalho.num_referencias; i++) {
+    uint64_t de = pares[2 * i];
+    uint64_t para = pares[2 * i + 1];
+    if (!gc_imagem_deslocamento_valido(inicios, cabecalho.tamanho_area, de) ||
+        !gc_imagem_deslocamento_valido(inicios, cabecalho.tamanho_area,
+                                       para)) {
+      continue; // Nao e o inicio de um objeto da imagem: ignorar
+    }
+    if (relocar) {
+      gc_imagem_corrigir_campos(area + de, GC_OBJETO(area + de)->tamanho,
+                                (uintptr_t)(cabecalho.base + para),
+                                (uintptr_t)(area + para));
+    }
+    gc->referencias[gc->num_referencias].de = gc_comprimir(area + de);
+    gc->referencias[gc->num_referencias].para = gc_comprimir(area + para);
+    gc->num_referencias++;
+  }
+
+  // Registar raizes
+  for (size_t i = 0; i < cabecalho.num_raizes; i++) {
+    if (gc_imagem_deslocamento_valido(inicios, cabecalho.tamanho_area,
+                                      entradas[i])) {
+      gc->raizes[gc->num_raizes++] = area + entradas[i];
+    }
+  }
+
+  // Os bits passam a ser os de marcaçao da imagem
+  if (inicios) {
+    memset(inicios, 0, GC_IMAGEM_TAMANHO_MARCAS(cabecalho.tamanho_area));
+  }
+  free(entradas);
+  return gc;
+}
@@ -13,50 +13,344 @@
 #define GC_H
 
 #include <gc.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 
 /**
  * @brief Constantes usadas pelo coletor de lixo.
  *
  * @param GC_OBJETO_MARCADO Indica que um objeto está marcado como alcançavel.
  * @param GC_OBJETO_NAO_MARCADO Indica que um objeto não está marcado.
+ * @param GC_BANDEIRA_INTERNADA Objeto é uma string da tabela de internamento.
+ * @param GC_BANDEIRA_CANDIDATA Objeto está no buffer de candidatos a ciclo.
+ * @param GC_BANDEIRA_LIBERTADA Objeto morto pela contagem, por libertar.
+ * @param GC_BANDEIRA_IMAGEM Objeto vive numa imagem mapeada, fora das paginas.
+ * @param GC_BANDEIRA_FINALIZAVEL Objeto tem finalizador por correr.
  * @param GC_MAX_RAIZES Número máximo de raízes que podem ser registadas.
  * @param GC_MAX_REFERENCIAS Máximo de referências que podem ser registadas.
+ * @param GC_MAX_FRACAS Máximo de referências fracas que podem ser registadas.
+ * @param GC_MAX_EFEMEROS Máximo de entradas na tabela de efémeros.
  * @param GC_LIMIAR_COLETA Limiar de ocupação da heap para acionar a coleta.
+ * @param GC_REGIAO_BLOCO_PADRAO Tamanho por omissão do primeiro bloco de uma
+ * região, cabeçalho incluído (uma página do pool).
+ * @param GC_ALINHAMENTO Alinhamento dos objetos alocados em regiões.
+ * @param GC_TAMANHO_PAGINA Tamanho (e alinhamento) das páginas do pool.
+ * @param GC_NUM_CLASSES Número de classes de tamanho de objetos pequenos.
+ * @param GC_TAMANHO_MAX_PEQUENO Maior slot servido por páginas partilhadas.
+ * @param GC_CLASSE_GRANDE Classe das páginas que guardam um objeto grande.
+ * @param GC_TAMANHO_BLOCO_POOL Tamanho dos blocos que o pool pede ao sistema.
+ * @param GC_POOL_ATRASO_PADRAO Atraso por omissão (ms) antes de devolver
+ * uma página livre ao sistema.
+ * @param GC_POOL_ALOCACOES_VERIFICAR Alocações entre verificações das páginas
+ * do pool livres há mais do que o atraso.
+ * @param GC_MAX_TIPOS Máximo de tipos com função de marcação (por processo).
+ * @param GC_MAX_DECREMENTOS Decrementos adiados antes de serem processados.
+ * @param GC_MAX_CANDIDATOS Candidatos a raiz de ciclo antes de uma recolha.
+ * @param GC_CONTAGEM_MAX Contagem máxima; um objeto que a atinja fica com a
+ * contagem fixa e só é libertado pela marcação.
+ * @param GC_TAMANHO_MAX_OBJETO Maior tamanho de objeto (campo de 40 bits).
+ * @param GC_STRINGS_CAPACIDADE_INICIAL Entradas iniciais da tabela de strings
+ * internadas (potência de 2).
+ * @param GC_LOTE_FINALIZADORES Finalizadores retirados da fila de cada vez.
  */
 #define GC_OBJETO_MARCADO 1
 #define GC_OBJETO_NAO_MARCADO 0
+#define GC_BANDEIRA_INTERNADA 0x01
+#define GC_BANDEIRA_CANDIDATA 0x02
+#define GC_BANDEIRA_LIBERTADA 0x04
+#define GC_BANDEIRA_IMAGEM 0x08
+#define GC_BANDEIRA_FINALIZAVEL 0x40
 #define GC_MAX_RAIZES 1024
 #define GC_MAX_REFERENCIAS 8192
+#define GC_MAX_FRACAS 1024
+#define GC_MAX_EFEMEROS 4096
 #define GC_LIMIAR_COLETA 0.75
+#define GC_REGIAO_BLOCO_PADRAO (64 * 1024)
+#define GC_ALINHAMENTO 16
+#define GC_TAMANHO_PAGINA (64 * 1024)
+#define GC_NUM_CLASSES 32
+#define GC_TAMANHO_MAX_PEQUENO 8192
+#define GC_CLASSE_GRANDE UINT32_MAX
+#define GC_TAMANHO_BLOCO_POOL (2 * 1024 * 1024)
+#define GC_POOL_ATRASO_PADRAO 1000
+#define GC_POOL_ALOCACOES_VERIFICAR 256
+#define GC_MAX_TIPOS 4096
+#define GC_MAX_DECREMENTOS 256
+#define GC_MAX_CANDIDATOS 1024
+#define GC_CONTAGEM_MAX ((1u << 24) - 1)
+#define GC_TAMANHO_MAX_OBJETO (((uint64_t)1 << 40) - 1)
+#define GC_STRINGS_CAPACIDADE_INICIAL 256
+#define GC_LOTE_FINALIZADORES 64
+
+/**
+ * @brief Arredonda um tamanho para o multiplo seguinte de GC_ALINHAMENTO.
+ */
+#define GC_ALINHAR(n)                                                          \
+  (((n) + GC_ALINHAMENTO - 1) & ~(size_t)(GC_ALINHAMENTO - 1))
+
+/**
+ * @brief Referencia interna para um objeto do heap.
+ *
+ * Por omissao e um apontador. Com GC_REFERENCIAS_COMPRIMIDAS definido e
+ * um deslocamento de 32 bits, em unidades de 8 bytes, a partir da base
+ * da reserva de memoria do pool (gc_base_comprimida); 0 representa NULL.
+ * Isto limita o heap de todos os coletores do processo a 32 GiB.
+ *
+ * @param GC_DESLOCAMENTO_COMPRIMIDO Bits descartados ao comprimir.
+ * @param GC_RESERVA_COMPRIMIDA Tamanho da reserva (2^32 unidades de 8 bytes).
+ */
+#ifdef GC_REFERENCIAS_COMPRIMIDAS
+#define GC_DESLOCAMENTO_COMPRIMIDO 3
+#define GC_RESERVA_COMPRIMIDA ((size_t)1 << (32 + GC_DESLOCAMENTO_COMPRIMIDO))
+
+typedef uint32_t gc_ref_t;
+
+extern char *gc_base_comprimida;
+
+/**
+ * @brief Comprime um apontador; devolve 0 se estiver fora da reserva.
+ */
+static inline gc_ref_t gc_comprimir(const void *ptr) {
+  uintptr_t base = (uintptr_t)gc_base_comprimida;
+  if (!base || (uintptr_t)ptr <= base ||
+      (uintptr_t)ptr >= base + GC_RESERVA_COMPRIMIDA) {
+    return 0;
+  }
+  return (gc_ref_t)(((uintptr_t)ptr - base) >> GC_DESLOCAMENTO_COMPRIMIDO);
+}
+
+/**
+ * @brief Descomprime uma referencia.
+ */
+static inline void *gc_descomprimir(gc_ref_t ref) {
+  return ref ? gc_base_comprimida + ((uintptr_t)ref << GC_DESLOCAMENTO_COMPRIMIDO)
+             : NULL;
+}
+#else
+typedef void *gc_ref_t;
+
+static inline gc_ref_t gc_comprimir(const void *ptr) { return (void *)ptr; }
+
+static inline void *gc_descomprimir(gc_ref_t ref) { return ref; }
+#endif
 
 /**
  * @brief Estrutura para representar um objeto gerenciado pelo coletor.
  *
+ * O cabeçalho precede os dados do objeto no mesmo slot; os dados estao
+ * GC_CABECALHO_OBJETO bytes depois (ver GC_DADOS).
+ *
  * @param tamanho Tamanho do objeto em bytes.
+ * @param contagem Numero de referencias registadas para o objeto (modo de
+ * contagem de referencias; fixa em GC_CONTAGEM_MAX).
+ * @param proximo Referencia para o próximo objeto na lista ligada.
  * @param marcado Indica se o objeto está marcado como alcançável.
- * @param dados Apontador para os dados do objeto.
- * @param proximo Apontador para o próximo objeto na lista ligada.
+ * @param bandeiras Combinação de GC_BANDEIRA_*.
+ * @param tipo Tipo registado com gc_registar_tipo, ou 0.
  */
 typedef struct GCObject {
-  size_t tamanho;
-  int marcado;
-  void *dados;
-  struct GCObject *proximo;
+  uint64_t tamanho : 40;
+  uint64_t contagem : 24;
+  gc_ref_t proximo;
+  uint8_t marcado;
+  uint8_t bandeiras;
+  uint16_t tipo;
 } gc_object_t;
 
+/**
+ * @brief Tamanho alinhado do cabeçalho que precede os dados de um objeto.
+ *
+ * Com referencias comprimidas sao 16 bytes. Sem elas, gc_object_t tem 24
+ * bytes e o alinhamento a GC_ALINHAMENTO leva o cabeçalho a 32.
+ */
+#define GC_CABECALHO_OBJETO GC_ALINHAR(sizeof(gc_object_t))
+
+/**
+ * @brief Acesso aos dados e ao proximo objeto a partir de um cabeçalho, e
+ * ao cabeçalho a partir dos dados de um objeto do heap.
+ */
+#define GC_DADOS(obj) ((void *)((char *)(obj) + GC_CABECALHO_OBJETO))
+#define GC_OBJETO(dados)                                                       \
+  ((gc_object_t *)((char *)(dados) - GC_CABECALHO_OBJETO))
+#define GC_PROXIMO(obj) ((gc_object_t *)gc_descomprimir((obj)->proximo))
+
+/**
+ * @brief Cabeçalho de uma pagina do pool.
+ *
+ * Uma pagina pequena guarda objetos de uma so classe de tamanho; uma
+ * pagina grande (GC_CLASSE_GRANDE) ocupa num_paginas paginas contiguas
+ * e guarda um unico objeto.
+ *
+ * @param proxima Proxima pagina do coletor dono.
+ * @param proxima_disponivel Proxima pagina da mesma classe com slots livres.
+ * @param classe Classe de tamanho, ou GC_CLASSE_GRANDE.
+ * @param tamanho_slot Tamanho de cada slot em bytes.
+ * @param num_slots Numero de slots da pagina.
+ * @param livres Numero de slots livres (lista livre e zona por usar).
+ * @param lista_livre Lista de slots libertados.
+ * @param incremento Inicio da zona de slots nunca usados.
+ * @param num_paginas Numero de paginas contiguas ocupadas.
+ * @param zerada Indica se a zona de slots nunca usados esta a zeros.
+ */
+typedef struct GCPagina {
+  struct GCPagina *proxima;
+  struct GCPagina *proxima_disponivel;
+  uint32_t classe;
+  uint32_t tamanho_slot;
+  uint32_t num_slots;
+  uint32_t livres;
+  void *lista_livre;
+  char *incremento;
+  size_t num_paginas;
+  bool zerada;
+} gc_pagina_t;
+
 /**
  * @brief Estrutura para representar uma referência entre objetos.
  *
- * @param de Apontador para o objeto de origem.
- * @param para Apontador para o objeto de destino.
+ * @param de Referencia para o objeto de origem.
+ * @param para Referencia para o objeto de destino.
  */
 typedef struct GCReferencia {
-  void *de;
-  void *para;
+  gc_ref_t de;
+  gc_ref_t para;
 } gc_referencia_t;
 
+/**
+ * @brief Estrutura para representar um efémero (par chave/valor).
+ *
+ * O valor so e mantido vivo enquanto a chave for alcançavel por outro
+ * caminho; quando a chave morre, a entrada e removida.
+ *
+ * @param chave Apontador para o objeto chave.
+ * @param valor Apontador para o objeto valor.
+ */
+typedef struct GCEfemero {
+  void *chave;
+  void *valor;
+} gc_efemero_t;
+
+/**
+ * @brief Cabecalho de um objeto alocado numa regiao.
+ *
+ * @param tamanho Tamanho do objeto em bytes.
+ * @param escapou Indica se o objeto e referenciado de fora da regiao.
+ * @param destino Copia promovida para o heap, ou NULL.
+ */
+typedef struct GCRegiaoObjeto {
+  size_t tamanho;
+  bool escapou;
+  void *destino;
+} gc_regiao_objeto_t;
+
+/**
+ * @brief Bloco de memoria de uma regiao, alocado por incremento.
+ *
+ * @param proximo Apontador para o bloco anterior da regiao.
+ * @param capacidade Numero de bytes de dados do bloco.
+ * @param usado Numero de bytes ja alocados.
+ * @param num_paginas Numero de paginas do pool ocupadas pelo bloco (0 se o
+ * bloco veio de malloc).
+ */
+typedef struct GCRegiaoBloco {
+  struct GCRegiaoBloco *proximo;
+  size_t capacidade;
+  size_t usado;
+  size_t num_paginas;
+} gc_regiao_bloco_t;
+
+/**
+ * @brief Estrutura para representar uma regiao de alocaçao temporaria.
+ *
+ * @param gc Coletor de lixo a que a regiao pertence.
+ * @param blocos Lista de blocos, o mais recente primeiro.
+ * @param num_escapes Numero de objetos referenciados de fora da regiao.
+ * @param num_referencias Referencias registadas que envolvem a regiao.
+ * @param num_registos Raizes, campos fracos e efémeros registados com
+ * objetos da regiao (nunca decresce; so serve para evitar percorre-los).
+ * @param proxima Proxima regiao ativa do coletor.
+ */
+typedef struct GCRegiao {
+  gc_t *gc;
+  gc_regiao_bloco_t *blocos;
+  size_t num_escapes;
+  size_t num_referencias;
+  size_t num_registos;
+  struct GCRegiao *proxima;
+} gc_regiao_t;
+
+/**
+ * @brief Estado do gravador de traços de alocaçao.
+ *
+ * @param ficheiro Ficheiro onde os eventos sao escritos.
+ * @param ultimo_endereco Ultimo endereço escrito (base da codificaçao delta).
+ * @param suspenso Profundidade de suspensao; eventos nao sao gravados se > 0.
+ * @param erro Indica se ocorreu algum erro de escrita.
+ */
+typedef struct GCGravador {
+  FILE *ficheiro;
+  uintptr_t ultimo_endereco;
+  int suspenso;
+  bool erro;
+} gc_gravador_t;
+
+/**
+ * @brief Entrada da tabela de strings internadas.
+ *
+ * A tabela usa endereçamento aberto com sondagem linear; uma entrada
+ * com dados NULL esta livre. As entradas sao fracas: a string e
+ * removida da tabela quando o varrimento liberta o objeto.
+ *
+ * @param hash Hash FNV-1a do conteudo da string.
+ * @param dados Apontador para a string (dados do objeto gerido).
+ */
+typedef struct GCString {
+  uint64_t hash;
+  char *dados;
+} gc_string_t;
+
+/**
+ * @brief Objeto com finalizador.
+ *
+ * @param obj Apontador para o cabeçalho do objeto.
+ * @param finalizador Funçao a chamar com os dados do objeto.
+ */
+typedef struct GCFinalizavel {
+  gc_object_t *obj;
+  gc_finalizador_t finalizador;
+} gc_finalizavel_t;
+
+/**
+ * @brief Funçao que recebe os objetos visitados pelas funçoes de marcaçao
+ * fora da marcaçao (por exemplo no snapshot).
+ *
+ * @param contexto Valor registado com a funçao.
+ * @param objeto Apontador para o objeto visitado.
+ */
+typedef void (*gc_visitante_t)(void *contexto, void *objeto);
+
+/**
+ * @brief Imagem do heap mapeada por gc_carregar_imagem.
+ *
+ * Os bits de marcaçao dos objetos da imagem ficam fora dela, um por
+ * GC_ALINHAMENTO bytes da area, para que a coleta nao escreva nos
+ * cabeçalhos e as paginas mapeadas continuem partilhadas.
+ *
+ * @param inicio Inicio da area de objetos mapeada.
+ * @param tamanho Tamanho da area em bytes.
+ * @param marcas Bits de marcaçao, indexados pelo deslocamento do cabeçalho.
+ * @param proxima Proxima imagem do coletor.
+ */
+typedef struct GCImagem {
+  void *inicio;
+  size_t tamanho;
+  uint8_t *marcas;
+  struct GCImagem *proxima;
+} gc_imagem_t;
+
 /**
  * @brief Estrutura principal do coletor de lixo.
  *
@@ -65,9 +359,53 @@ typedef struct GCReferencia {
  * @param num_raizes Numero de raizes registadas.
  * @param referencias Array de referencias.
  * @param num_referencias Numero de referencias registadas.
+ * @param fracas Array de campos que guardam referencias fracas.
+ * @param num_fracas Numero de referencias fracas registadas.
+ * @param efemeros Tabela de efémeros.
+ * @param num_efemeros Numero de efémeros registados.
  * @param tamanho_heap Tamanho total da heap.
  * @param memoria_usada Memória atualmente usada.
  * @param coletas_realizadas Número de coletas realizadas.
+ * @param alocacoes Alocações desde a última verificação do pool.
+ * @param gravador Gravador de traços ativo, ou NULL.
+ * @param regioes Lista de regioes ativas.
+ * @param paginas Lista das paginas pequenas do coletor.
+ * @param disponiveis Paginas com slots livres, por classe de tamanho.
+ * @param paginas_usadas Numero de paginas obtidas do pool.
+ * @param quota_paginas Maximo de paginas que o coletor pode obter (0 = sem
+ * limite).
+ * @param contagem_ativa Indica se o modo de contagem de referencias esta ativo.
+ * @param decrementos Objetos com decrementos de contagem adiados.
+ * @param num_decrementos Numero de decrementos adiados.
+ * @param candidatos Possiveis raizes de ciclos de lixo.
+ * @param num_candidatos Numero de candidatos.
+ * @param num_tipados Numero de objetos com funçao de marcaçao.
+ * @param visitante Recebe os objetos de gc_visitar em vez da marcaçao, ou
+ * NULL.
+ * @param visitante_contexto Contexto passado a visitante.
+ * @param strings Tabela de strings internadas, ou NULL.
+ * @param num_strings Numero de strings internadas.
+ * @param cap_strings Capacidade da tabela de strings (potencia de 2).
+ * @param imagens Imagens do heap mapeadas pelo coletor.
+ * @param limite_rigido Indica se tamanho_heap e um limite rigido.
+ * @param sem_memoria Funçao chamada quando uma alocaçao nao cabe, ou NULL.
+ * @param sem_memoria_contexto Contexto passado a sem_memoria.
+ * @param sem_memoria_ativa Indica se sem_memoria esta a correr.
+ * @param finalizaveis Objetos com finalizador ainda alcançaveis.
+ * @param num_finalizaveis Numero de objetos com finalizador.
+ * @param cap_finalizaveis Capacidade do array finalizaveis.
+ * @param fila Objetos mortos a finalizar (protegida por trinco_finalizar).
+ * @param num_fila Numero de objetos na fila.
+ * @param cap_fila Capacidade da fila.
+ * @param em_execucao Lote retirado da fila cujos finalizadores estao a
+ * correr (protegido por trinco_finalizar).
+ * @param num_em_execucao Numero de objetos no lote.
+ * @param trinco_finalizar Protege a fila e o lote em execuçao.
+ * @param trinco_executor Garante um so executor de finalizadores de cada vez.
+ * @param sinal_finalizar Acorda a thread de finalizadores.
+ * @param thread_finalizadores Thread dedicada aos finalizadores.
+ * @param finalizadores_ativa Indica se a thread dedicada existe.
+ * @param finalizadores_parar Pede a thread dedicada para terminar.
  */
 typedef struct GC {
   gc_object_t *objetos;
@@ -75,9 +413,50 @@ typedef struct GC {
   size_t num_raizes;
   gc_referencia_t referencias[GC_MAX_REFERENCIAS];
   size_t num_referencias;
+  void **fracas[GC_MAX_FRACAS];
+  size_t num_fracas;
+  gc_efemero_t efemeros[GC_MAX_EFEMEROS];
+  size_t num_efemeros;
   size_t tamanho_heap;
   size_t memoria_usada;
   size_t coletas_realizadas;
+  size_t alocacoes;
+  gc_gravador_t *gravador;
+  gc_regiao_t *regioes;
+  gc_pagina_t *paginas;
+  gc_pagina_t *disponiveis[GC_NUM_CLASSES];
+  size_t paginas_usadas;
+  size_t quota_paginas;
+  bool contagem_ativa;
+  gc_object_t *decrementos[GC_MAX_DECREMENTOS];
+  size_t num_decrementos;
+  gc_object_t *candidatos[GC_MAX_CANDIDATOS];
+  size_t num_candidatos;
+  size_t num_tipados;
+  gc_visitante_t visitante;
+  void *visitante_contexto;
+  gc_string_t *strings;
+  size_t num_strings;
+  size_t cap_strings;
+  gc_imagem_t *imagens;
+  bool limite_rigido;
+  gc_sem_memoria_t sem_memoria;
+  void *sem_memoria_contexto;
+  bool sem_memoria_ativa;
+  gc_finalizavel_t *finalizaveis;
+  size_t num_finalizaveis;
+  size_t cap_finalizaveis;
+  gc_finalizavel_t *fila;
+  size_t num_fila;
+  size_t cap_fila;
+  gc_finalizavel_t em_execucao[GC_LOTE_FINALIZADORES];
+  size_t num_em_execucao;
+  pthread_mutex_t trinco_finalizar;
+  pthread_mutex_t trinco_executor;
+  pthread_cond_t sinal_finalizar;
+  pthread_t thread_finalizadores;
+  bool finalizadores_ativa;
+  bool finalizadores_parar;
 } gc_t;
 
 /**
@@ -88,6 +467,203 @@ typedef struct GC {
  */
 void gc_marcar(gc_t *gc, void *objeto);
 
+/**
+ * @brief Marca os valores dos efémeros cujas chaves estao marcadas.
+ *
+ * Repete ate nao haver alteraçoes, porque marcar um valor pode tornar
+ * alcançavel a chave de outro efémero.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_marcar_efemeros(gc_t *gc);
+
+/**
+ * @brief Limpa referencias fracas e efémeros que envolvem um objeto libertado.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param dados Apontador para os dados do objeto libertado.
+ * @param tamanho Tamanho do objeto em bytes.
+ */
+void gc_remover_fracas(gc_t *gc, void *dados, size_t tamanho);
+
+/**
+ * @brief Atualiza referencias fracas e efémeros de um objeto realocado.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param antigo Apontador para os dados antigos.
+ * @param novo Apontador para os dados novos.
+ * @param tamanho Numero de bytes copiados para o novo bloco.
+ */
+void gc_atualizar_fracas(gc_t *gc, void *antigo, void *novo, size_t tamanho);
+
+/**
+ * @brief Limpa as referencias fracas para objetos ainda nao marcados.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_limpar_fracas_inalcancaveis(gc_t *gc);
+
+/**
+ * @brief Incrementa a contagem de um objeto referenciado (modo de contagem).
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param dados Apontador para os dados do objeto (ignorado se nao for do heap).
+ */
+void gc_contagem_incrementar(gc_t *gc, void *dados);
+
+/**
+ * @brief Adia o decremento da contagem de um objeto (modo de contagem).
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param dados Apontador para os dados do objeto (ignorado se nao for do heap).
+ */
+void gc_contagem_decrementar(gc_t *gc, void *dados);
+
+/**
+ * @brief Aplica os decrementos adiados e liberta os objetos mortos.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param ciclos Se true, recolhe tambem os ciclos entre os candidatos.
+ * @return Numero de bytes libertados.
+ */
+size_t gc_contagem_processar(gc_t *gc, bool ciclos);
+
+/**
+ * @brief Esvazia os buffers de decrementos e candidatos.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_contagem_descartar(gc_t *gc);
+
+/**
+ * @brief Recalcula as contagens a partir das referencias e raizes atuais.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_contagem_recalcular(gc_t *gc);
+
+/**
+ * @brief Liberta um objeto ja retirado da lista de objetos.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto.
+ */
+void gc_libertar_objeto(gc_t *gc, gc_object_t *obj);
+
+/**
+ * @brief Liberta os objetos com GC_BANDEIRA_LIBERTADA.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @return Numero de bytes libertados.
+ */
+size_t gc_varrer_libertados(gc_t *gc);
+
+/**
+ * @brief Chama a funçao de marcaçao do tipo de um objeto, se tiver.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto.
+ */
+void gc_tracar_objeto(gc_t *gc, gc_object_t *obj);
+
+/**
+ * @brief Retira da tabela de strings internadas um objeto libertado.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto (com GC_BANDEIRA_INTERNADA).
+ */
+void gc_remover_string(gc_t *gc, gc_object_t *obj);
+
+/**
+ * @brief Mantem vivos os objetos a finalizar e poe na fila os objetos com
+ * finalizador que ficaram inalcançaveis. Chamada depois da marcaçao.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_marcar_finalizaveis(gc_t *gc);
+
+/**
+ * @brief Corre ja o finalizador de um objeto libertado fora de uma coleta.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto (com
+ * GC_BANDEIRA_FINALIZAVEL).
+ */
+void gc_correr_finalizador(gc_t *gc, gc_object_t *obj);
+
+/**
+ * @brief Passa o finalizador de um objeto realocado para a copia.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param antigo Apontador para o cabeçalho do objeto antigo.
+ * @param novo Apontador para o cabeçalho do objeto novo.
+ */
+void gc_mover_finalizador(gc_t *gc, gc_object_t *antigo, gc_object_t *novo);
+
+/**
+ * @brief Indica se ha objetos na fila ou em finalizaçao.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @return true se algum finalizador esta por correr ou a correr.
+ */
+bool gc_finalizadores_pendentes(gc_t *gc);
+
+/**
+ * @brief Inicializa o estado dos finalizadores de um coletor novo.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_finalizadores_inicializar(gc_t *gc);
+
+/**
+ * @brief Para a thread de finalizadores, corre todos os finalizadores
+ * (pendentes e de objetos ainda vivos) e liberta o estado.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_finalizadores_terminar(gc_t *gc);
+
+/**
+ * @brief Marca os objetos do heap referenciados a partir de regioes ativas.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_marcar_regioes(gc_t *gc);
+
+/**
+ * @brief Encontra a regiao ativa que contem um apontador.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param ptr Apontador para os dados de um objeto.
+ * @return Apontador para a regiao, ou NULL se o apontador nao pertence
+ * a nenhuma regiao ativa.
+ */
+gc_regiao_t *gc_encontrar_regiao(gc_t *gc, void *ptr);
+
+/**
+ * @brief Atualiza a contabilidade das regioes ao registar uma referencia.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param de Apontador para o objeto de origem.
+ * @param para Apontador para o objeto de destino.
+ */
+void gc_regiao_registar_referencia(gc_t *gc, void *de, void *para);
+
+/**
+ * @brief Conta uma raiz, campo fraco ou efémero na regiao de um apontador.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param ptr Apontador registado.
+ */
+void gc_regiao_registar(gc_t *gc, void *ptr);
+
+/**
+ * @brief Liberta um bloco de regiao, devolvendo-o ao pool ou com free.
+ *
+ * @param bloco Apontador para o bloco.
+ */
+void gc_regiao_libertar_bloco(gc_regiao_bloco_t *bloco);
+
 /**
  * @brief Varre o heap e liberta objetos não marcados/alcançaveis.
  *
@@ -96,6 +672,161 @@ void gc_marcar(gc_t *gc, void *objeto);
  */
 size_t gc_varrer(gc_t *gc);
 
+/**
+ * @brief Cria um objeto gerido sem verificar o limiar de coleta.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @param zerado Se nao for NULL, recebe true quando os dados ja estao a zeros.
+ * @return Apontador para os dados do objeto, ou NULL em caso de falha.
+ */
+void *gc_alocar_objeto(gc_t *gc, size_t tamanho, bool *zerado);
+
+/**
+ * @brief Aloca como gc_alocar, indicando se os dados ja estao a zeros.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @param zerado Se nao for NULL, recebe true quando os dados ja estao a zeros.
+ * @return Apontador para a memoria alocada, ou NULL em caso de falha.
+ */
+void *gc_alocar_interno(gc_t *gc, size_t tamanho, bool *zerado);
+
+/**
+ * @brief Obtem paginas contiguas do pool partilhado por todos os coletores.
+ *
+ * @param num_paginas Numero de paginas contiguas.
+ * @param zeradas Se nao for NULL, recebe true quando as paginas vem a zeros
+ * do sistema (mapeamento novo ou devolvidas com MADV_DONTNEED).
+ * @return Apontador para a primeira pagina, ou NULL em caso de falha.
+ */
+void *gc_pool_obter(size_t num_paginas, bool *zeradas);
+
+/**
+ * @brief Devolve paginas ao pool partilhado.
+ *
+ * @param paginas Apontador para a primeira pagina.
+ * @param num_paginas Numero de paginas contiguas.
+ */
+void gc_pool_devolver(void *paginas, size_t num_paginas);
+
+/**
+ * @brief Devolve ao sistema as paginas livres ha mais do que o atraso
+ * configurado.
+ *
+ * @param forcar Se true, ignora o atraso e devolve todas as paginas livres.
+ * @return Numero de paginas devolvidas ao sistema.
+ */
+size_t gc_pool_descomprometer_antigas(bool forcar);
+
+/**
+ * @brief Mapeia parte de um ficheiro em copia-na-escrita, para o heap.
+ *
+ * @param fd Descritor do ficheiro.
+ * @param tamanho Numero de bytes a mapear.
+ * @param deslocamento Deslocamento no ficheiro (multiplo de pagina).
+ * @param preferido Endereço preferido, ou NULL.
+ * @return Apontador para o mapeamento, ou NULL em caso de falha.
+ */
+void *gc_pool_mapear_ficheiro(int fd, size_t tamanho, uint64_t deslocamento,
+                              void *preferido);
+
+/**
+ * @brief Desfaz um mapeamento feito por gc_pool_mapear_ficheiro.
+ *
+ * @param inicio Apontador devolvido por gc_pool_mapear_ficheiro.
+ * @param tamanho Numero de bytes mapeados.
+ */
+void gc_pool_desmapear_ficheiro(void *inicio, size_t tamanho);
+
+/**
+ * @brief Indica se um objeto de uma imagem esta marcado.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho (com GC_BANDEIRA_IMAGEM).
+ * @return true se o objeto estiver marcado.
+ */
+bool gc_imagem_marcado(gc_t *gc, const gc_object_t *obj);
+
+/**
+ * @brief Marca um objeto de uma imagem.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho (com GC_BANDEIRA_IMAGEM).
+ */
+void gc_imagem_marcar(gc_t *gc, const gc_object_t *obj);
+
+/**
+ * @brief Desmarca todos os objetos das imagens do coletor.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_imagem_desmarcar(gc_t *gc);
+
+/**
+ * @brief Indica se um objeto esta marcado, do heap ou de uma imagem.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto.
+ * @return true se o objeto estiver marcado.
+ */
+static inline bool gc_objeto_marcado(gc_t *gc, const gc_object_t *obj) {
+  if (obj->bandeiras & GC_BANDEIRA_IMAGEM) {
+    return gc_imagem_marcado(gc, obj);
+  }
+  return obj->marcado == GC_OBJETO_MARCADO;
+}
+
+/**
+ * @brief Marca um objeto, do heap ou de uma imagem.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto.
+ */
+static inline void gc_objeto_marcar(gc_t *gc, gc_object_t *obj) {
+  if (obj->bandeiras & GC_BANDEIRA_IMAGEM) {
+    gc_imagem_marcar(gc, obj);
+  } else {
+    obj->marcado = GC_OBJETO_MARCADO;
+  }
+}
+
+/**
+ * @brief Reserva um slot para um objeto nas paginas do coletor.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho dos dados do objeto em bytes.
+ * @param zerado Se nao for NULL, recebe true quando os dados estao a zeros.
+ * @return Apontador para o cabeçalho do objeto, ou NULL em caso de falha.
+ */
+gc_object_t *gc_paginas_alocar(gc_t *gc, size_t tamanho, bool *zerado);
+
+/**
+ * @brief Liberta o slot de um objeto.
+ *
+ * Paginas pequenas que fiquem vazias so sao devolvidas ao pool por
+ * gc_paginas_reorganizar; paginas grandes sao devolvidas de imediato.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto.
+ */
+void gc_paginas_libertar(gc_t *gc, gc_object_t *obj);
+
+/**
+ * @brief Devolve ao pool as paginas vazias e refaz as listas de paginas
+ * com slots livres. Chamada no fim de cada varrimento.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_paginas_reorganizar(gc_t *gc);
+
+/**
+ * @brief Devolve ao pool todas as paginas do coletor.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_paginas_libertar_todas(gc_t *gc);
+
 /**
  * @brief Encontra o objeto referente a um apontador.
  *
@@ -113,4 +844,29 @@ gc_object_t *gc_encontrar_objeto(gc_t *gc, void *dados);
  */
 bool gc_verificar_limiar_coleta(gc_t *gc);
 
+/**
+ * @brief Grava um evento no traço de alocaçoes, se houver gravador ativo.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param evento Tipo do evento (gc_traco_evento_t).
+ * @param a Primeiro endereço do evento, ou NULL.
+ * @param b Segundo endereço do evento, ou NULL.
+ * @param tamanho Tamanho associado ao evento, ou 0.
+ */
+void gc_gravar_evento(gc_t *gc, int evento, void *a, void *b, size_t tamanho);
+
+/**
+ * @brief Suspende a gravaçao de eventos (chamadas internas do coletor).
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_gravar_suspender(gc_t *gc);
+
+/**
+ * @brief Retoma a gravaçao de eventos suspensa por gc_gravar_suspender.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_gravar_retomar(gc_t *gc);
+
 #endif // !GC_INTERNO_H
@@ -29,19 +29,23 @@ void gc_marcar(gc_t *gc, void *objeto) {
 
   // Encontrar o objeto correspondente ao apontador
   gc_object_t *gc_obj = gc_encontrar_objeto(gc, objeto);
-    if (!gc_obj || gc_obj->marcado == GC_OBJETO_MARCADO) {
+    if (!gc_obj || gc_objeto_marcado(gc, gc_obj)) {
       return; // Erro: objeto não encontrado ou já marcado
     }
 
   // Marca o objeto
-  gc_obj->marcado = GC_OBJETO_MARCADO;
+  gc_objeto_marcar(gc, gc_obj);
 
   // Marca recursivamente todos os objetos referenciados por este objeto
+  gc_ref_t ref = gc_comprimir(objeto);
   for (size_t i = 0; i < gc->num_referencias; i++) {
-    if (gc->referencias[i].de == objeto) {
-      gc_marcar(gc, gc->referencias[i].para);
+    if (gc->referencias[i].de == ref) {
+      gc_marcar(gc, gc_descomprimir(gc->referencias[i].para));
     }
   }
+
+  // Marca os campos descritos pela funçao de marcaçao do tipo
+  gc_tracar_objeto(gc, gc_obj);
 }   
 
 /**
@@ -59,9 +63,12 @@ void gc_desmarcar_todos(gc_t* gc) {
 
     gc_object_t *gc_obj = gc->objetos;
     while (gc_obj) {
-        gc_obj->marcado = GC_OBJETO_NAO_MARCADO;
-        gc_obj = gc_obj->proximo;
-    }   
+        if (!(gc_obj->bandeiras & GC_BANDEIRA_IMAGEM)) {
+            gc_obj->marcado = GC_OBJETO_NAO_MARCADO;
+        }
+        gc_obj = GC_PROXIMO(gc_obj);
+    }
+    gc_imagem_desmarcar(gc);
 }
 
 /**
@@ -83,4 +90,60 @@ void gc_marcar_alcancaveis(gc_t *gc) {
     for (size_t i = 0; i < gc->num_raizes; i++) {
         gc_marcar(gc, gc->raizes[i]);
     }
+
+    gc_marcar_regioes(gc);
+    gc_marcar_efemeros(gc);
+    gc_marcar_finalizaveis(gc);
+}
+
+/**
+ * @brief Marca os objetos do heap referenciados a partir de regioes ativas.
+ *
+ * Os objetos de uma regiao vivem ate ao fim dela, por isso funcionam
+ * como raizes para tudo o que referenciam.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_marcar_regioes(gc_t *gc) {
+  if (!gc || !gc->regioes) {
+    return; // Erro: coletor nulo, ou sem regioes ativas
+  }
+
+  for (size_t i = 0; i < gc->num_referencias; i++) {
+    if (gc_encontrar_regiao(gc, gc_descomprimir(gc->referencias[i].de))) {
+      gc_marcar(gc, gc_descomprimir(gc->referencias[i].para));
+    }
+  }
+}
+
+/**
+ * @brief Marca os valores dos efémeros cujas chaves estao marcadas.
+ *
+ * Um efémero mantem o valor vivo apenas se a chave for alcançavel.
+ * Como marcar um valor pode tornar alcançavel a chave de outro efémero,
+ * o processo repete-se ate nao haver alteraçoes.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_marcar_efemeros(gc_t *gc) {
+  if (!gc) {
+    return; // Erro: coletor nulo
+  }
+
+  bool alterado = true;
+  while (alterado) {
+    alterado = false;
+    for (size_t i = 0; i < gc->num_efemeros; i++) {
+      gc_object_t *chave = gc_encontrar_objeto(gc, gc->efemeros[i].chave);
+      if (!chave || !gc_objeto_marcado(gc, chave)) {
+        continue; // Chave ainda nao alcançavel
+      }
+
+      gc_object_t *valor = gc_encontrar_objeto(gc, gc->efemeros[i].valor);
+      if (valor && !gc_objeto_marcado(gc, valor)) {
+        gc_marcar(gc, gc->efemeros[i].valor);
+        alterado = true;
+      }
+    }
+  }
 }
\ No newline at end of file
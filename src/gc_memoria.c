@@ -10,10 +10,78 @@
  */
 
 #include "gc.h"
+#include "gc_formato.h"
 #include "gc_interno.h"
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * @brief Cria um objeto gerido sem verificar o limiar de coleta.
+ *
+ * Esta funçao e usada internamente quando uma coleta a meio da operaçao
+ * poderia libertar objetos que ainda nao estao ligados ao grafo.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @param zerado Se nao for NULL, recebe true quando os dados ja estao a zeros.
+ * @return Apontador para os dados do objeto, ou NULL em caso de falha.
+ */
+void *gc_alocar_objeto(gc_t *gc, size_t tamanho, bool *zerado) {
+  if ((uint64_t)tamanho > GC_TAMANHO_MAX_OBJETO) {
+    return NULL; // Erro: tamanho nao cabe no cabeçalho
+  }
+
+  // Reservar um slot nas paginas do coletor (cabeçalho seguido dos dados)
+  gc_object_t *novo_objeto = gc_paginas_alocar(gc, tamanho, zerado);
+  if (!novo_objeto) {
+    return NULL; // Erro: falha na alocacao ou quota esgotada
+  }
+
+  // Inicializar o novo_objeto
+  novo_objeto->tamanho = tamanho;
+  novo_objeto->contagem = 0;
+  novo_objeto->marcado = GC_OBJETO_NAO_MARCADO;
+  novo_objeto->bandeiras = 0;
+  novo_objeto->tipo = 0;
+
+  // Adicionar o novo objeto à lista de objetos do coletor
+  novo_objeto->proximo = gc_comprimir(gc->objetos);
+  gc->objetos = novo_objeto;
+
+  // Atualizar a memoria usada
+  gc->memoria_usada += tamanho;
+
+  return GC_DADOS(novo_objeto);
+}
+
+/**
+ * @brief Retira um objeto da lista e liberta-o, sem varrer o heap.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param gc_obj Apontador para o cabeçalho do objeto.
+ */
+static void gc_realocar_libertar(gc_t *gc, gc_object_t *gc_obj) {
+  // Os buffers da contagem podem apontar para o objeto
+  gc_contagem_descartar(gc);
+
+  if (gc->objetos == gc_obj) {
+    gc->objetos = GC_PROXIMO(gc_obj);
+  } else {
+    gc_object_t *anterior = gc->objetos;
+    while (anterior && GC_PROXIMO(anterior) != gc_obj) {
+      anterior = GC_PROXIMO(anterior);
+    }
+    if (anterior) {
+      anterior->proximo = gc_obj->proximo;
+    }
+  }
+  gc_libertar_objeto(gc, gc_obj);
+
+  if (gc->contagem_ativa) {
+    gc_contagem_recalcular(gc);
+  }
+}
+
 /**
  * @brief Realoca memoria para um objeto gerenciado pelo coletor de lixo.
  * 
@@ -39,8 +107,8 @@ void* gc_realocar(gc_t *gc, void *ptr, size_t novo_tamanho) {
   if (novo_tamanho == 0) {
     gc_object_t *gc_obj = gc_encontrar_objeto(gc, ptr);
     if (gc_obj) {
-      gc_obj->marcado = GC_OBJETO_NAO_MARCADO;
-      gc_varrer(gc);
+      gc_realocar_libertar(gc, gc_obj);
+      gc_gravar_evento(gc, GC_TRACO_REALOCAR, ptr, NULL, 0);
     }
     return NULL;
   }
@@ -51,8 +119,25 @@ void* gc_realocar(gc_t *gc, void *ptr, size_t novo_tamanho) {
     return NULL; // Erro: objeto nao encontrado
   }
 
-  // Alocar novo bloco de memoria
-  void *novo_ptr = gc_alocar(gc, novo_tamanho);
+  // Alocar novo bloco de memoria (gravado como um unico evento de
+  // realocaçao). O antigo fica como raiz temporaria, para que uma coleta
+  // desencadeada pela alocaçao nao o liberte antes da copia.
+  bool raiz_temporaria = gc->num_raizes < GC_MAX_RAIZES;
+  if (raiz_temporaria) {
+    gc->raizes[gc->num_raizes++] = ptr;
+  }
+  gc_gravar_suspender(gc);
+  void *novo_ptr = raiz_temporaria ? gc_alocar(gc, novo_tamanho)
+                                   : gc_alocar_objeto(gc, novo_tamanho, NULL);
+  gc_gravar_retomar(gc);
+  if (raiz_temporaria) {
+    for (size_t i = gc->num_raizes; i-- > 0;) {
+      if (gc->raizes[i] == ptr) {
+        gc->raizes[i] = gc->raizes[--gc->num_raizes];
+        break;
+      }
+    }
+  }
   if (!novo_ptr) {
     return NULL; // Erro: falha na alocacao
   }
@@ -61,21 +146,44 @@ void* gc_realocar(gc_t *gc, void *ptr, size_t novo_tamanho) {
   size_t tamanho_copia = gc_obj->tamanho < novo_tamanho ? gc_obj->tamanho : novo_tamanho;
   memcpy(novo_ptr, ptr, tamanho_copia);
 
-  // Marca o objeto antigo para ser coletado
-  gc_obj->marcado = GC_OBJETO_NAO_MARCADO;
+  // O novo objeto mantem o tipo (e a funçao de marcaçao) do antigo
+  GC_OBJETO(novo_ptr)->tipo = gc_obj->tipo;
+  if (gc_obj->tipo != 0) {
+    gc->num_tipados++;
+  }
+
+  // O finalizador acompanha os dados
+  if (gc_obj->bandeiras & GC_BANDEIRA_FINALIZAVEL) {
+    gc_mover_finalizador(gc, gc_obj, GC_OBJETO(novo_ptr));
+  }
 
   // Atualizar as referencias
+  gc_ref_t ref_antiga = gc_comprimir(ptr);
+  gc_ref_t ref_nova = gc_comprimir(novo_ptr);
   for (size_t i = 0; i < gc->num_referencias; i++) {
-    if (gc->referencias[i].de == ptr) {
-      gc->referencias[i].de = novo_ptr;
+    if (gc->referencias[i].de == ref_antiga) {
+      gc->referencias[i].de = ref_nova;
+    }
+    if (gc->referencias[i].para == ref_antiga) {
+      gc->referencias[i].para = ref_nova;
     }
-    if (gc->referencias[i].para == ptr) {
-      gc->referencias[i].para = novo_ptr;
+  }
+
+  // Raizes do objeto antigo passam para o novo
+  for (size_t i = 0; i < gc->num_raizes; i++) {
+    if (gc->raizes[i] == ptr) {
+      gc->raizes[i] = novo_ptr;
     }
   }
 
-  // Varrer a memoria para libertar o objeto antigo
-  gc_varrer(gc);
+  // Atualizar referencias fracas e efémeros
+  gc_atualizar_fracas(gc, ptr, novo_ptr, tamanho_copia);
+
+  // Libertar so o objeto antigo (varrer libertaria tambem objetos
+  // alocados depois da ultima coleta, incluindo o novo)
+  gc_realocar_libertar(gc, gc_obj);
+
+  gc_gravar_evento(gc, GC_TRACO_REALOCAR, ptr, novo_ptr, novo_tamanho);
 
   return novo_ptr; // Retorna o novo apontador
 }  
@@ -104,9 +212,10 @@ void *gc_alocar_array(gc_t *gc, size_t num_elementos, size_t tamanho_elemento) {
     return NULL;
   }
 
-  // Alocar memoria para o array
-  void *array = gc_alocar(gc, tamanho_total);
-  if (array) {
+  // Alocar memoria para o array; paginas novas do sistema ja vem a zeros
+  bool zerado = false;
+  void *array = gc_alocar_interno(gc, tamanho_total, &zerado);
+  if (array && !zerado) {
     // Inicializar o array com zeros
     memset(array, 0, tamanho_total);
   }
@@ -0,0 +1,906 @@
+/**
+ * @file gc_paginas.c
+ * @brief Implementaçao do pool de paginas partilhado pelos coletores.
+ *
+ * Este arquivo contem o pool de paginas do processo, de onde todos os
+ * coletores (gc_t) obtem memoria e para onde a devolvem, e o alocador
+ * de objetos por classes de tamanho que trabalha sobre essas paginas.
+ * Cada coletor pode ter uma quota de paginas; paginas que fiquem vazias
+ * depois de um varrimento sao devolvidas ao pool para outros coletores.
+ *
+ * O pool obtem memoria do sistema com mmap, em blocos de
+ * GC_TAMANHO_BLOCO_POOL alinhados, e devolve ao sistema (madvise) as
+ * paginas que fiquem livres durante mais do que o atraso configurado.
+ * Nao ha thread para isso: o atraso e verificado quando o pool e usado,
+ * no fim de cada varrimento e periodicamente na alocaçao.
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "gc.h"
+#include "gc_interno.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+/**
+ * @brief Tamanho alinhado do cabeçalho de pagina.
+ */
+#define GC_CABECALHO_PAGINA GC_ALINHAR(sizeof(gc_pagina_t))
+
+/**
+ * @brief Pagina livre que ainda ocupa memoria fisica.
+ *
+ * @param pagina Apontador para a pagina.
+ * @param instante Instante (ms, relogio monotono) em que ficou livre.
+ */
+typedef struct GCPoolLivre {
+  void *pagina;
+  uint64_t instante;
+} gc_pool_livre_t;
+
+/**
+ * @brief Estado do pool de paginas do processo.
+ *
+ * @param trinco Protege o pool de acessos concorrentes.
+ * @param sujas Paginas livres ainda residentes, por ordem de libertaçao.
+ * @param num_sujas Numero de paginas livres residentes.
+ * @param cap_sujas Capacidade do array sujas.
+ * @param limpas Paginas livres ja devolvidas ao sistema (madvise).
+ * @param num_limpas Numero de paginas devolvidas ao sistema.
+ * @param cap_limpas Capacidade do array limpas.
+ * @param bloco Proxima pagina por usar do bloco atual.
+ * @param restantes Paginas por usar no bloco atual.
+ * @param em_uso Numero de paginas entregues a coletores.
+ * @param limpas_zeradas Indica se as paginas em limpas leem zeros (falso
+ * depois de se usar MADV_FREE, que pode manter o conteudo antigo).
+ * @param atraso_ms Tempo que uma pagina livre fica residente.
+ * @param opcoes Opçoes GC_POOL_* ativas.
+ */
+typedef struct GCPool {
+  pthread_mutex_t trinco;
+  gc_pool_livre_t *sujas;
+  size_t num_sujas;
+  size_t cap_sujas;
+  void **limpas;
+  size_t num_limpas;
+  size_t cap_limpas;
+  char *bloco;
+  size_t restantes;
+  size_t em_uso;
+  bool limpas_zeradas;
+  long atraso_ms;
+  int opcoes;
+} gc_pool_t;
+
+static gc_pool_t gc_pool = {PTHREAD_MUTEX_INITIALIZER,
+                            NULL, 0, 0, NULL, 0, 0, NULL, 0, 0, true,
+                            GC_POOL_ATRASO_PADRAO, 0};
+
+/**
+ * @brief Devolve o instante atual em milissegundos (relogio monotono).
+ */
+static uint64_t gc_pool_agora(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000 + (uint64_t)t.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Garante espaço para mais uma entrada num array do pool.
+ *
+ * @return true se houver espaço, false em caso de falha na alocacao.
+ */
+static bool gc_pool_crescer(void **array, size_t *capacidade, size_t usado,
+                            size_t tamanho_entrada) {
+  if (usado < *capacidade) {
+    return true;
+  }
+  size_t nova = *capacidade ? 2 * *capacidade : 64;
+  void *novo = realloc(*array, nova * tamanho_entrada);
+  if (!novo) {
+    return false;
+  }
+  *array = novo;
+  *capacidade = nova;
+  return true;
+}
+
+#ifdef GC_REFERENCIAS_COMPRIMIDAS
+/**
+ * @brief Base da reserva de onde vem toda a memoria do pool.
+ *
+ * Com referencias comprimidas todos os objetos tem de estar a menos de
+ * GC_RESERVA_COMPRIMIDA bytes da base, por isso o pool reserva esse
+ * espaço de endereçamento de uma vez (sem memoria fisica) e vai-o
+ * entregando por ordem. Sequencias de paginas devolvidas nao podem ser
+ * desfeitas com munmap; ficam numa lista para serem reutilizadas.
+ */
+char *gc_base_comprimida = NULL;
+
+/**
+ * @brief Sequencia de paginas livre dentro da reserva.
+ *
+ * @param inicio Apontador para a primeira pagina.
+ * @param tamanho Numero de bytes da sequencia.
+ */
+typedef struct GCPoolSequencia {
+  char *inicio;
+  size_t tamanho;
+} gc_pool_sequencia_t;
+
+/**
+ * @brief Estado da reserva, protegido por um trinco proprio (pode ser
+ * adquirido com o trinco do pool, nunca o contrario).
+ *
+ * @param trinco Protege a reserva de acessos concorrentes.
+ * @param livre Primeiro byte da reserva ainda por entregar.
+ * @param sequencias Sequencias devolvidas, disponiveis para reutilizar.
+ * @param num_sequencias Numero de sequencias devolvidas.
+ * @param cap_sequencias Capacidade do array sequencias.
+ */
+static struct {
+  pthread_mutex_t trinco;
+  char *livre;
+  gc_pool_sequencia_t *sequencias;
+  size_t num_sequencias;
+  size_t cap_sequencias;
+} gc_reserva = {PTHREAD_MUTEX_INITIALIZER, NULL, NULL, 0, 0};
+#endif
+
+/**
+ * @brief Reserva memoria do sistema com um dado alinhamento.
+ *
+ * Pede alinhamento bytes a mais e corta as pontas. Com referencias
+ * comprimidas a memoria vem da reserva partilhada.
+ *
+ * @param tamanho Numero de bytes (multiplo de GC_TAMANHO_PAGINA).
+ * @param alinhamento Alinhamento pretendido (potencia de 2).
+ * @return Apontador para a memoria, ou NULL em caso de falha.
+ */
+static void *gc_pool_mapear(size_t tamanho, size_t alinhamento) {
+#ifdef GC_REFERENCIAS_COMPRIMIDAS
+  char *resultado = NULL;
+
+  pthread_mutex_lock(&gc_reserva.trinco);
+  if (!gc_base_comprimida) {
+    // Reservar o espaço de endereçamento sem memoria fisica nem commit
+    size_t extra = GC_TAMANHO_BLOCO_POOL;
+    char *mapa = (char *)mmap(NULL, GC_RESERVA_COMPRIMIDA + extra, PROT_NONE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                              -1, 0);
+    if (mapa == MAP_FAILED) {
+      pthread_mutex_unlock(&gc_reserva.trinco);
+      return NULL; // Erro: falha no mmap
+    }
+    gc_base_comprimida = (char *)(((uintptr_t)mapa + extra - 1) &
+                                  ~(uintptr_t)(extra - 1));
+    // A base nunca e entregue: um objeto nela comprimir-se-ia em 0 (NULL)
+    gc_reserva.livre = gc_base_comprimida + GC_TAMANHO_PAGINA;
+  }
+
+  // Primeiro, uma sequencia devolvida onde caiba um troço alinhado
+  for (size_t i = 0; i < gc_reserva.num_sequencias; i++) {
+    gc_pool_sequencia_t *seq = &gc_reserva.sequencias[i];
+    char *inicio = (char *)(((uintptr_t)seq->inicio + alinhamento - 1) &
+                            ~(uintptr_t)(alinhamento - 1));
+    char *fim = seq->inicio + seq->tamanho;
+    if (inicio > fim || tamanho > (size_t)(fim - inicio)) {
+      continue;
+    }
+
+    // O que sobra antes do troço fica nesta entrada, o que sobra depois
+    // numa entrada nova
+    size_t antes = inicio - seq->inicio;
+    size_t depois = fim - (inicio + tamanho);
+    if (antes > 0 && depois > 0) {
+      if (!gc_pool_crescer((void **)&gc_reserva.sequencias,
+                           &gc_reserva.cap_sequencias,
+                           gc_reserva.num_sequencias,
+                           sizeof(gc_pool_sequencia_t))) {
+        continue;
+      }
+      seq = &gc_reserva.sequencias[i];
+      gc_reserva.sequencias[gc_reserva.num_sequencias].inicio =
+          inicio + tamanho;
+      gc_reserva.sequencias[gc_reserva.num_sequencias].tamanho = depois;
+      gc_reserva.num_sequencias++;
+      seq->tamanho = antes;
+    } else if (antes > 0) {
+      seq->tamanho = antes;
+    } else if (depois > 0) {
+      seq->inicio = inicio + tamanho;
+      seq->tamanho = depois;
+    } else {
+      *seq = gc_reserva.sequencias[--gc_reserva.num_sequencias];
+    }
+    resultado = inicio;
+    break;
+  }
+
+  // Depois, o resto da reserva
+  if (!resultado) {
+    char *inicio = (char *)(((uintptr_t)gc_reserva.livre + alinhamento - 1) &
+                            ~(uintptr_t)(alinhamento - 1));
+    char *fim = gc_base_comprimida + GC_RESERVA_COMPRIMIDA;
+    if (inicio <= fim && tamanho <= (size_t)(fim - inicio) &&
+        mprotect(inicio, tamanho, PROT_READ | PROT_WRITE) == 0) {
+      resultado = inicio;
+      gc_reserva.livre = inicio + tamanho;
+    }
+  }
+  pthread_mutex_unlock(&gc_reserva.trinco);
+
+  if (!resultado) {
+    return NULL; // Erro: reserva esgotada (limite de 32 GiB)
+  }
+  uintptr_t inicio = (uintptr_t)resultado;
+#else
+  size_t extra = alinhamento;
+  char *mapa = (char *)mmap(NULL, tamanho + extra, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapa == MAP_FAILED) {
+    return NULL; // Erro: falha no mmap
+  }
+
+  uintptr_t inicio = ((uintptr_t)mapa + alinhamento - 1) &
+                     ~(uintptr_t)(alinhamento - 1);
+  size_t antes = inicio - (uintptr_t)mapa;
+  size_t depois = extra - antes;
+  if (antes > 0) {
+    munmap(mapa, antes);
+  }
+  if (depois > 0) {
+    munmap((char *)inicio + tamanho, depois);
+  }
+#endif
+
+  if ((gc_pool.opcoes & GC_POOL_PAGINAS_ENORMES) &&
+      tamanho >= GC_TAMANHO_BLOCO_POOL) {
+#ifdef MADV_HUGEPAGE
+    madvise((void *)inicio, tamanho, MADV_HUGEPAGE);
+#endif
+  }
+
+  return (void *)inicio;
+}
+
+/**
+ * @brief Devolve ao sistema memoria obtida com gc_pool_mapear.
+ *
+ * Com referencias comprimidas o espaço de endereçamento fica na reserva:
+ * a memoria fisica e libertada e a sequencia guardada para reutilizar,
+ * junta com as sequencias livres vizinhas.
+ *
+ * @param inicio Apontador devolvido por gc_pool_mapear.
+ * @param tamanho Numero de bytes.
+ */
+static void gc_pool_desmapear(void *inicio, size_t tamanho) {
+#ifdef GC_REFERENCIAS_COMPRIMIDAS
+  madvise(inicio, tamanho, MADV_DONTNEED);
+
+  pthread_mutex_lock(&gc_reserva.trinco);
+  // Juntar as sequencias vizinhas, para a reserva nao se fragmentar
+  char *comeco = (char *)inicio;
+  char *fim = comeco + tamanho;
+  for (size_t i = 0; i < gc_reserva.num_sequencias;) {
+    gc_pool_sequencia_t *seq = &gc_reserva.sequencias[i];
+    if (seq->inicio + seq->tamanho == comeco) {
+      comeco = seq->inicio;
+    } else if (seq->inicio == fim) {
+      fim += seq->tamanho;
+    } else {
+      i++;
+      continue;
+    }
+    *seq = gc_reserva.sequencias[--gc_reserva.num_sequencias];
+  }
+
+  if (fim == gc_reserva.livre) {
+    // A sequencia acaba onde comeca o resto da reserva: volta a ele
+    gc_reserva.livre = comeco;
+  } else if (gc_pool_crescer((void **)&gc_reserva.sequencias,
+                             &gc_reserva.cap_sequencias,
+                             gc_reserva.num_sequencias,
+                             sizeof(gc_pool_sequencia_t))) {
+    gc_reserva.sequencias[gc_reserva.num_sequencias].inicio = comeco;
+    gc_reserva.sequencias[gc_reserva.num_sequencias].tamanho = fim - comeco;
+    gc_reserva.num_sequencias++;
+  }
+  pthread_mutex_unlock(&gc_reserva.trinco);
+#else
+  munmap(inicio, tamanho);
+#endif
+}
+
+/**
+ * @brief Mapeia parte de um ficheiro em copia-na-escrita, para o heap.
+ *
+ * Sem referencias comprimidas tenta-se o endereço preferido sem
+ * substituir mapeamentos existentes; se estiver ocupado, o sistema
+ * escolhe outro. Com referencias comprimidas o ficheiro e mapeado
+ * sobre uma sequencia da reserva e o endereço preferido e ignorado.
+ *
+ * @param fd Descritor do ficheiro.
+ * @param tamanho Numero de bytes a mapear.
+ * @param deslocamento Deslocamento no ficheiro (multiplo de pagina).
+ * @param preferido Endereço preferido, ou NULL.
+ * @return Apontador para o mapeamento, ou NULL em caso de falha.
+ */
+void *gc_pool_mapear_ficheiro(int fd, size_t tamanho, uint64_t deslocamento,
+                              void *preferido) {
+#ifdef GC_REFERENCIAS_COMPRIMIDAS
+  (void)preferido;
+  size_t reservado = (tamanho + GC_TAMANHO_PAGINA - 1) &
+                     ~(size_t)(GC_TAMANHO_PAGINA - 1);
+  void *inicio = gc_pool_mapear(reservado, GC_TAMANHO_PAGINA);
+  if (!inicio) {
+    return NULL; // Erro: reserva esgotada
+  }
+  if (mmap(inicio, tamanho, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+           fd, (off_t)deslocamento) == MAP_FAILED) {
+    gc_pool_desmapear(inicio, reservado);
+    return NULL; // Erro: falha no mmap
+  }
+  return inicio;
+#else
+  int fixo = 0;
+#ifdef MAP_FIXED_NOREPLACE
+  fixo = preferido ? MAP_FIXED_NOREPLACE : 0;
+#endif
+  void *inicio = mmap(preferido, tamanho, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | fixo, fd, (off_t)deslocamento);
+  if (inicio == MAP_FAILED && fixo) {
+    // Endereço preferido ocupado: deixar o sistema escolher
+    inicio = mmap(NULL, tamanho, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                  (off_t)deslocamento);
+  }
+  return inicio == MAP_FAILED ? NULL : inicio; // Erro: falha no mmap
+#endif
+}
+
+/**
+ * @brief Desfaz um mapeamento feito por gc_pool_mapear_ficheiro.
+ *
+ * Com referencias comprimidas a sequencia volta a ser memoria anonima
+ * e e devolvida a reserva.
+ *
+ * @param inicio Apontador devolvido por gc_pool_mapear_ficheiro.
+ * @param tamanho Numero de bytes mapeados.
+ */
+void gc_pool_desmapear_ficheiro(void *inicio, size_t tamanho) {
+#ifdef GC_REFERENCIAS_COMPRIMIDAS
+  size_t reservado = (tamanho + GC_TAMANHO_PAGINA - 1) &
+                     ~(size_t)(GC_TAMANHO_PAGINA - 1);
+  if (mmap(inicio, reservado, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1,
+           0) == MAP_FAILED) {
+    return; // Erro: a sequencia fica perdida para a reserva
+  }
+  gc_pool_desmapear(inicio, reservado);
+#else
+  munmap(inicio, tamanho);
+#endif
+}
+
+static size_t gc_pool_descomprometer_trancado(bool forcar);
+
+/**
+ * @brief Devolve ao sistema a memoria fisica de uma pagina livre.
+ *
+ * A pagina continua reservada; com MADV_DONTNEED volta a ler zeros.
+ */
+static void gc_pool_descomprometer_pagina(void *pagina) {
+#ifdef MADV_FREE
+  if (gc_pool.opcoes & GC_POOL_MADV_FREE) {
+    madvise(pagina, GC_TAMANHO_PAGINA, MADV_FREE);
+    gc_pool.limpas_zeradas = false;
+    return;
+  }
+#endif
+  madvise(pagina, GC_TAMANHO_PAGINA, MADV_DONTNEED);
+}
+
+/**
+ * @brief Obtem paginas contiguas do pool partilhado por todos os coletores.
+ *
+ * Paginas isoladas vem, por ordem de preferencia, das paginas livres
+ * ainda residentes, das ja devolvidas ao sistema, ou de um bloco novo.
+ * Sequencias de varias paginas (objetos grandes) tem um mapeamento
+ * proprio, que e desfeito quando sao devolvidas (gc_pool_desmapear).
+ *
+ * Memoria acabada de mapear e paginas devolvidas com MADV_DONTNEED leem
+ * zeros, o que permite ao chamador evitar limpar a memoria outra vez.
+ *
+ * @param num_paginas Numero de paginas contiguas.
+ * @param zeradas Se nao for NULL, recebe true quando as paginas vem a zeros.
+ * @return Apontador para a primeira pagina, ou NULL em caso de falha.
+ */
+void *gc_pool_obter(size_t num_paginas, bool *zeradas) {
+  if (num_paginas == 0 || num_paginas > SIZE_MAX / GC_TAMANHO_PAGINA - 1) {
+    return NULL; // Erro: numero de paginas invalido
+  }
+
+  if (num_paginas > 1) {
+    size_t tamanho = num_paginas * GC_TAMANHO_PAGINA;
+    void *paginas = gc_pool_mapear(
+        tamanho, tamanho >= GC_TAMANHO_BLOCO_POOL ? GC_TAMANHO_BLOCO_POOL
+                                                  : GC_TAMANHO_PAGINA);
+    if (zeradas) {
+      *zeradas = true; // gc_pool_mapear devolve sempre memoria por tocar
+    }
+    if (paginas) {
+      pthread_mutex_lock(&gc_pool.trinco);
+      gc_pool.em_uso += num_paginas;
+      pthread_mutex_unlock(&gc_pool.trinco);
+    }
+    return paginas;
+  }
+
+  void *pagina = NULL;
+  bool zerada = false;
+
+  pthread_mutex_lock(&gc_pool.trinco);
+  gc_pool_descomprometer_trancado(false);
+  if (gc_pool.num_sujas > 0) {
+    pagina = gc_pool.sujas[--gc_pool.num_sujas].pagina;
+  } else if (gc_pool.num_limpas > 0) {
+    pagina = gc_pool.limpas[--gc_pool.num_limpas];
+    zerada = gc_pool.limpas_zeradas;
+    if (gc_pool.num_limpas == 0) {
+      gc_pool.limpas_zeradas = true;
+    }
+  } else {
+    if (gc_pool.restantes == 0) {
+      gc_pool.bloco = (char *)gc_pool_mapear(GC_TAMANHO_BLOCO_POOL,
+                                             GC_TAMANHO_BLOCO_POOL);
+      if (gc_pool.bloco) {
+        gc_pool.restantes = GC_TAMANHO_BLOCO_POOL / GC_TAMANHO_PAGINA;
+      }
+    }
+    if (gc_pool.restantes > 0) {
+      pagina = gc_pool.bloco;
+      gc_pool.bloco += GC_TAMANHO_PAGINA;
+      gc_pool.restantes--;
+      zerada = true;
+    }
+  }
+  if (pagina) {
+    gc_pool.em_uso++;
+  }
+  pthread_mutex_unlock(&gc_pool.trinco);
+
+  if (zeradas) {
+    *zeradas = zerada;
+  }
+
+  return pagina;
+}
+
+/**
+ * @brief Devolve paginas ao pool partilhado.
+ *
+ * Sequencias de varias paginas sao devolvidas ao sistema de imediato;
+ * paginas isoladas ficam residentes ate gc_pool_descomprometer.
+ *
+ * @param paginas Apontador para a primeira pagina.
+ * @param num_paginas Numero de paginas contiguas.
+ */
+void gc_pool_devolver(void *paginas, size_t num_paginas) {
+  if (!paginas || num_paginas == 0) {
+    return; // Erro: paginas nulas
+  }
+
+  if (num_paginas > 1) {
+    gc_pool_desmapear(paginas, num_paginas * GC_TAMANHO_PAGINA);
+    pthread_mutex_lock(&gc_pool.trinco);
+    gc_pool.em_uso -= num_paginas;
+    pthread_mutex_unlock(&gc_pool.trinco);
+    return;
+  }
+
+  pthread_mutex_lock(&gc_pool.trinco);
+  gc_pool.em_uso--;
+  gc_pool_descomprometer_trancado(false);
+  if (gc_pool_crescer((void **)&gc_pool.sujas, &gc_pool.cap_sujas,
+                      gc_pool.num_sujas, sizeof(gc_pool_livre_t))) {
+    gc_pool.sujas[gc_pool.num_sujas].pagina = paginas;
+    gc_pool.sujas[gc_pool.num_sujas].instante = gc_pool_agora();
+    gc_pool.num_sujas++;
+  } else {
+    // Sem memoria para a registar: pelo menos nao ocupa memoria fisica
+    gc_pool_descomprometer_pagina(paginas);
+  }
+  pthread_mutex_unlock(&gc_pool.trinco);
+}
+
+/**
+ * @brief Devolve ao sistema as paginas livres ha mais do que o atraso.
+ * O chamador detem o trinco do pool.
+ *
+ * As paginas em sujas estao por ordem de libertaçao, por isso as antigas
+ * sao um prefixo e basta olhar para a primeira para saber se ha alguma.
+ *
+ * @param forcar Se true, ignora o atraso e devolve todas as paginas livres.
+ * @return Numero de paginas devolvidas ao sistema.
+ */
+static size_t gc_pool_descomprometer_trancado(bool forcar) {
+  if (gc_pool.num_sujas == 0 || (!forcar && gc_pool.atraso_ms < 0)) {
+    return 0;
+  }
+
+  uint64_t agora = gc_pool_agora();
+  uint64_t atraso = forcar ? 0 : (uint64_t)gc_pool.atraso_ms;
+  size_t devolvidas = 0;
+  while (devolvidas < gc_pool.num_sujas &&
+         agora - gc_pool.sujas[devolvidas].instante >= atraso &&
+         gc_pool_crescer((void **)&gc_pool.limpas, &gc_pool.cap_limpas,
+                         gc_pool.num_limpas, sizeof(void *))) {
+    void *pagina = gc_pool.sujas[devolvidas++].pagina;
+    gc_pool_descomprometer_pagina(pagina);
+    gc_pool.limpas[gc_pool.num_limpas++] = pagina;
+  }
+
+  // A ordem mantem-se: as mais recentes ficam no fim
+  if (devolvidas > 0) {
+    memmove(gc_pool.sujas, gc_pool.sujas + devolvidas,
+            (gc_pool.num_sujas - devolvidas) * sizeof(gc_pool_livre_t));
+    gc_pool.num_sujas -= devolvidas;
+  }
+
+  return devolvidas;
+}
+
+/**
+ * @brief Devolve ao sistema as paginas livres ha mais do que o atraso
+ * configurado.
+ *
+ * Chamada no fim de cada varrimento e, a cada
+ * GC_POOL_ALOCACOES_VERIFICAR alocaçoes, por gc_alocar; gc_pool_obter e
+ * gc_pool_devolver fazem a mesma verificaçao.
+ *
+ * @param forcar Se true, ignora o atraso e devolve todas as paginas livres.
+ * @return Numero de paginas devolvidas ao sistema.
+ */
+size_t gc_pool_descomprometer_antigas(bool forcar) {
+  pthread_mutex_lock(&gc_pool.trinco);
+  size_t devolvidas = gc_pool_descomprometer_trancado(forcar);
+  pthread_mutex_unlock(&gc_pool.trinco);
+
+  return devolvidas;
+}
+
+/**
+ * @brief Devolve imediatamente ao sistema todas as paginas livres do pool.
+ *
+ * @return Numero de paginas devolvidas ao sistema.
+ */
+size_t gc_pool_descomprometer(void) {
+  return gc_pool_descomprometer_antigas(true);
+}
+
+/**
+ * @brief Configura a devoluçao de memoria ao sistema e as paginas enormes.
+ *
+ * @param atraso_ms Tempo em ms que uma pagina livre fica residente antes de
+ * ser devolvida ao sistema (0 para imediato, negativo para nunca).
+ * @param opcoes Combinaçao de GC_POOL_PAGINAS_ENORMES e GC_POOL_MADV_FREE.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_pool_configurar(long atraso_ms, int opcoes) {
+  if (opcoes & ~(GC_POOL_PAGINAS_ENORMES | GC_POOL_MADV_FREE)) {
+    return -1; // Erro: opçao desconhecida
+  }
+
+  pthread_mutex_lock(&gc_pool.trinco);
+  gc_pool.atraso_ms = atraso_ms;
+  gc_pool.opcoes = opcoes;
+  pthread_mutex_unlock(&gc_pool.trinco);
+
+  return 0;
+}
+
+/**
+ * @brief Retorna estatisticas do pool de paginas partilhado.
+ *
+ * @param paginas_em_uso Apontador onde sera guardado o numero de paginas
+ * entregues a coletores.
+ * @param paginas_livres Apontador onde sera guardado o numero de paginas
+ * livres ainda residentes.
+ * @param paginas_devolvidas Apontador onde sera guardado o numero de
+ * paginas livres ja devolvidas ao sistema.
+ */
+void gc_pool_estatisticas(size_t *paginas_em_uso, size_t *paginas_livres,
+                          size_t *paginas_devolvidas) {
+  pthread_mutex_lock(&gc_pool.trinco);
+  if (paginas_em_uso) {
+    *paginas_em_uso = gc_pool.em_uso;
+  }
+  if (paginas_livres) {
+    *paginas_livres = gc_pool.num_sujas;
+  }
+  if (paginas_devolvidas) {
+    *paginas_devolvidas = gc_pool.num_limpas;
+  }
+  pthread_mutex_unlock(&gc_pool.trinco);
+}
+
+/**
+ * @brief Define a quota de paginas de um coletor.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param max_paginas Numero maximo de paginas (0 para sem limite).
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_definir_quota(gc_t *gc, size_t max_paginas) {
+  if (!gc) {
+    return -1; // Erro: coletor nulo
+  }
+
+  gc->quota_paginas = max_paginas;
+
+  return 0;
+}
+
+/**
+ * @brief Calcula a classe de tamanho de um slot.
+ *
+ * Ate 128 bytes as classes crescem de 16 em 16; depois ha quatro
+ * classes por cada potencia de 2, o que limita o desperdicio a 25%.
+ *
+ * @param tamanho Tamanho do slot (1 a GC_TAMANHO_MAX_PEQUENO).
+ * @return Indice da classe.
+ */
+static uint32_t gc_classe(size_t tamanho) {
+  if (tamanho <= 128) {
+    return (uint32_t)((tamanho + 15) / 16 - 1);
+  }
+
+  // Expoente da potencia de 2 imediatamente abaixo de tamanho
+  uint32_t expoente = 7;
+  while (((size_t)1 << (expoente + 1)) < tamanho) {
+    expoente++;
+  }
+  size_t passo = (size_t)1 << (expoente - 2);
+  size_t indice = (tamanho - ((size_t)1 << expoente) + passo - 1) / passo;
+
+  return 8 + (expoente - 7) * 4 + (uint32_t)indice - 1;
+}
+
+/**
+ * @brief Calcula o tamanho do slot de uma classe.
+ *
+ * @param classe Indice da classe.
+ * @return Tamanho do slot em bytes.
+ */
+static uint32_t gc_tamanho_classe(uint32_t classe) {
+  if (classe < 8) {
+    return (classe + 1) * 16;
+  }
+
+  uint32_t expoente = 7 + (classe - 8) / 4;
+  uint32_t indice = (classe - 8) % 4 + 1;
+
+  return (1u << expoente) + indice * (1u << (expoente - 2));
+}
+
+/**
+ * @brief Devolve a pagina que contem um objeto.
+ */
+static gc_pagina_t *gc_pagina_de(gc_object_t *obj) {
+  return (gc_pagina_t *)((uintptr_t)obj & ~(uintptr_t)(GC_TAMANHO_PAGINA - 1));
+}
+
+/**
+ * @brief Verifica se o coletor pode obter mais paginas.
+ */
+static bool gc_quota_permite(gc_t *gc, size_t num_paginas) {
+  return gc->quota_paginas == 0 ||
+         gc->paginas_usadas + num_paginas <= gc->quota_paginas;
+}
+
+/**
+ * @brief Obtem e prepara uma nova pagina pequena para uma classe.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param classe Indice da classe.
+ * @return Apontador para a pagina, ou NULL em caso de falha.
+ */
+static gc_pagina_t *gc_pagina_nova(gc_t *gc, uint32_t classe) {
+  if (!gc_quota_permite(gc, 1)) {
+    return NULL; // Erro: quota de paginas esgotada
+  }
+
+  bool zerada = false;
+  gc_pagina_t *pagina = (gc_pagina_t *)gc_pool_obter(1, &zerada);
+  if (!pagina) {
+    return NULL; // Erro: falha na alocacao
+  }
+
+  pagina->classe = classe;
+  pagina->tamanho_slot = gc_tamanho_classe(classe);
+  pagina->num_slots =
+      (GC_TAMANHO_PAGINA - GC_CABECALHO_PAGINA) / pagina->tamanho_slot;
+  pagina->livres = pagina->num_slots;
+  pagina->lista_livre = NULL;
+  pagina->incremento = (char *)pagina + GC_CABECALHO_PAGINA;
+  pagina->num_paginas = 1;
+  pagina->zerada = zerada;
+
+  pagina->proxima = gc->paginas;
+  gc->paginas = pagina;
+  pagina->proxima_disponivel = gc->disponiveis[classe];
+  gc->disponiveis[classe] = pagina;
+  gc->paginas_usadas++;
+
+  return pagina;
+}
+
+/**
+ * @brief Reserva um slot para um objeto nas paginas do coletor.
+ *
+ * Um slot esta a zeros se vier da zona nunca usada de uma pagina que
+ * veio a zeros do sistema; objetos grandes vem sempre de memoria nova.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho dos dados do objeto em bytes.
+ * @param zerado Se nao for NULL, recebe true quando os dados estao a zeros.
+ * @return Apontador para o cabeçalho do objeto, ou NULL em caso de falha.
+ */
+gc_object_t *gc_paginas_alocar(gc_t *gc, size_t tamanho, bool *zerado) {
+  if (tamanho > SIZE_MAX - GC_CABECALHO_PAGINA - GC_CABECALHO_OBJETO -
+                    GC_TAMANHO_PAGINA) {
+    return NULL; // Erro: overflow no tamanho
+  }
+
+  size_t total = GC_CABECALHO_OBJETO + tamanho;
+  gc_object_t *obj;
+  bool limpo;
+
+  if (total <= GC_TAMANHO_MAX_PEQUENO) {
+    uint32_t classe = gc_classe(total);
+
+    // Descartar paginas cheias do inicio da lista de disponiveis
+    gc_pagina_t *pagina = gc->disponiveis[classe];
+    while (pagina && pagina->livres == 0) {
+      pagina = pagina->proxima_disponivel;
+    }
+    gc->disponiveis[classe] = pagina;
+
+    if (!pagina) {
+      pagina = gc_pagina_nova(gc, classe);
+      if (!pagina) {
+        return NULL; // Erro: sem paginas
+      }
+    }
+
+    // Reutilizar um slot libertado ou avançar sobre a zona por usar
+    if (pagina->lista_livre) {
+      obj = (gc_object_t *)pagina->lista_livre;
+      pagina->lista_livre = *(void **)obj;
+      limpo = false;
+    } else {
+      obj = (gc_object_t *)pagina->incremento;
+      pagina->incremento += pagina->tamanho_slot;
+      limpo = pagina->zerada;
+    }
+    pagina->livres--;
+  } else {
+    // Objeto grande: paginas contiguas so para ele
+    size_t num_paginas =
+        (GC_CABECALHO_PAGINA + total + GC_TAMANHO_PAGINA - 1) /
+        GC_TAMANHO_PAGINA;
+    if (!gc_quota_permite(gc, num_paginas)) {
+      return NULL; // Erro: quota de paginas esgotada
+    }
+
+    gc_pagina_t *pagina = (gc_pagina_t *)gc_pool_obter(num_paginas, &limpo);
+    if (!pagina) {
+      return NULL; // Erro: falha na alocacao
+    }
+    pagina->classe = GC_CLASSE_GRANDE;
+    pagina->num_paginas = num_paginas;
+    pagina->zerada = limpo;
+    gc->paginas_usadas += num_paginas;
+
+    obj = (gc_object_t *)((char *)pagina + GC_CABECALHO_PAGINA);
+  }
+
+  if (zerado) {
+    *zerado = limpo;
+  }
+
+  return obj;
+}
+
+/**
+ * @brief Liberta o slot de um objeto.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto.
+ */
+void gc_paginas_libertar(gc_t *gc, gc_object_t *obj) {
+  gc_pagina_t *pagina = gc_pagina_de(obj);
+
+  if (pagina->classe == GC_CLASSE_GRANDE) {
+    gc->paginas_usadas -= pagina->num_paginas;
+    gc_pool_devolver(pagina, pagina->num_paginas);
+    return;
+  }
+
+  *(void **)obj = pagina->lista_livre;
+  pagina->lista_livre = obj;
+  pagina->livres++;
+}
+
+/**
+ * @brief Devolve ao pool as paginas vazias e refaz as listas de paginas
+ * com slots livres.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_paginas_reorganizar(gc_t *gc) {
+  for (uint32_t classe = 0; classe < GC_NUM_CLASSES; classe++) {
+    gc->disponiveis[classe] = NULL;
+  }
+
+  gc_pagina_t **atual = &gc->paginas;
+  while (*atual) {
+    gc_pagina_t *pagina = *atual;
+    if (pagina->livres == pagina->num_slots) {
+      // Pagina vazia: devolver ao pool para outros coletores
+      *atual = pagina->proxima;
+      gc->paginas_usadas--;
+      gc_pool_devolver(pagina, 1);
+      continue;
+    }
+    if (pagina->livres > 0) {
+      pagina->proxima_disponivel = gc->disponiveis[pagina->classe];
+      gc->disponiveis[pagina->classe] = pagina;
+    }
+    atual = &pagina->proxima;
+  }
+
+  // Devolver ao sistema a memoria das paginas livres ha tempo suficiente
+  gc_pool_descomprometer_antigas(false);
+}
+
+/**
+ * @brief Devolve ao pool todas as paginas do coletor.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_paginas_libertar_todas(gc_t *gc) {
+  // Objetos grandes tem paginas proprias
+  gc_object_t *obj = gc->objetos;
+  while (obj) {
+    gc_object_t *prox = GC_PROXIMO(obj);
+    if (obj->bandeiras & GC_BANDEIRA_IMAGEM) {
+      obj = prox; // Memoria da imagem, desmapeada pelo coletor
+      continue;
+    }
+    gc_pagina_t *pagina = gc_pagina_de(obj);
+    if (pagina->classe == GC_CLASSE_GRANDE) {
+      gc_pool_devolver(pagina, pagina->num_paginas);
+    }
+    obj = prox;
+  }
+
+  while (gc->paginas) {
+    gc_pagina_t *pagina = gc->paginas;
+    gc->paginas = pagina->proxima;
+    gc_pool_devolver(pagina, 1);
+  }
+
+  for (uint32_t classe = 0; classe < GC_NUM_CLASSES; classe++) {
+    gc->disponiveis[classe] = NULL;
+  }
+  gc->objetos = NULL;
+  gc->paginas_usadas = 0;
+}
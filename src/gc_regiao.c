@@ -0,0 +1,544 @@
+/**
+ * @file gc_regiao.c
+ * @brief Implementaçao das regioes de alocaçao temporaria.
+ *
+ * Este arquivo contem as funçoes das regioes: blocos de memoria onde os
+ * objetos sao alocados por incremento e libertados todos de uma vez no
+ * fim da regiao, sem passarem pela marcaçao e varredura. Objetos que
+ * escapam para o heap atraves de referencias sao promovidos no fim.
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#include "gc.h"
+#include "gc_interno.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Tamanhos alinhados dos cabeçalhos de bloco e de objeto.
+ */
+#define GC_REGIAO_CABECALHO_BLOCO GC_ALINHAR(sizeof(gc_regiao_bloco_t))
+#define GC_REGIAO_CABECALHO_OBJETO GC_ALINHAR(sizeof(gc_regiao_objeto_t))
+
+/**
+ * @brief Capacidade por omissao do primeiro bloco, para que o bloco
+ * inteiro caiba numa pagina do pool.
+ */
+#define GC_REGIAO_CAPACIDADE_PADRAO                                            \
+  (GC_REGIAO_BLOCO_PADRAO - GC_REGIAO_CABECALHO_BLOCO)
+
+/**
+ * @brief Devolve o inicio da zona de dados de um bloco.
+ */
+static char *gc_regiao_bloco_dados(gc_regiao_bloco_t *bloco) {
+  return (char *)bloco + GC_REGIAO_CABECALHO_BLOCO;
+}
+
+/**
+ * @brief Devolve o cabeçalho de um objeto alocado numa regiao.
+ */
+static gc_regiao_objeto_t *gc_regiao_cabecalho(void *ptr) {
+  return (gc_regiao_objeto_t *)((char *)ptr - GC_REGIAO_CABECALHO_OBJETO);
+}
+
+/**
+ * @brief Verifica se um apontador pertence a uma regiao.
+ *
+ * @param regiao Apontador para a regiao.
+ * @param ptr Apontador a verificar.
+ * @return true se o apontador esta dentro de um dos blocos da regiao.
+ */
+static bool gc_regiao_contem(gc_regiao_t *regiao, void *ptr) {
+  for (gc_regiao_bloco_t *bloco = regiao->blocos; bloco;
+       bloco = bloco->proximo) {
+    char *inicio = gc_regiao_bloco_dados(bloco);
+    if ((char *)ptr >= inicio && (char *)ptr < inicio + bloco->usado) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Adiciona um novo bloco a uma regiao.
+ *
+ * @param regiao Apontador para a regiao.
+ * @param minimo Numero minimo de bytes de dados do bloco.
+ * @return Apontador para o bloco, ou NULL em caso de falha.
+ */
+static gc_regiao_bloco_t *gc_regiao_novo_bloco(gc_regiao_t *regiao,
+                                               size_t minimo) {
+  // Cada bloco novo tem pelo menos o dobro da capacidade do anterior
+  size_t capacidade = regiao->blocos ? 2 * regiao->blocos->capacidade
+                                     : GC_REGIAO_CAPACIDADE_PADRAO;
+  if (capacidade < minimo) {
+    capacidade = minimo;
+  }
+  if (capacidade > SIZE_MAX - GC_REGIAO_CABECALHO_BLOCO - GC_TAMANHO_PAGINA) {
+    return NULL; // Erro: overflow no tamanho
+  }
+
+#ifdef GC_REFERENCIAS_COMPRIMIDAS
+  // Os blocos tem de estar na reserva do pool para que as referencias
+  // comprimidas os alcancem
+  size_t num_paginas = (GC_REGIAO_CABECALHO_BLOCO + capacidade +
+                        GC_TAMANHO_PAGINA - 1) / GC_TAMANHO_PAGINA;
+  gc_regiao_bloco_t *bloco =
+      (gc_regiao_bloco_t *)gc_pool_obter(num_paginas, NULL);
+  if (!bloco) {
+    return NULL; // Erro: falha na alocacao
+  }
+  capacidade = num_paginas * GC_TAMANHO_PAGINA - GC_REGIAO_CABECALHO_BLOCO;
+#else
+  size_t num_paginas = 0;
+  gc_regiao_bloco_t *bloco = (gc_regiao_bloco_t *)malloc(
+      GC_REGIAO_CABECALHO_BLOCO + capacidade);
+  if (!bloco) {
+    return NULL; // Erro: falha na alocacao
+  }
+#endif
+
+  bloco->num_paginas = num_paginas;
+  bloco->capacidade = capacidade;
+  bloco->usado = 0;
+  bloco->proximo = regiao->blocos;
+  regiao->blocos = bloco;
+
+  return bloco;
+}
+
+/**
+ * @brief Liberta um bloco de regiao, devolvendo-o ao pool ou com free.
+ *
+ * @param bloco Apontador para o bloco.
+ */
+void gc_regiao_libertar_bloco(gc_regiao_bloco_t *bloco) {
+#ifdef GC_REFERENCIAS_COMPRIMIDAS
+  gc_pool_devolver(bloco, bloco->num_paginas);
+#else
+  free(bloco);
+#endif
+}
+
+/**
+ * @brief Inicia uma regiao de alocaçao temporaria.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param capacidade Capacidade do primeiro bloco em bytes (0 para o padrao).
+ * @return Apontador para a regiao, ou NULL em caso de falha.
+ */
+gc_regiao_t *gc_regiao_inicio(gc_t *gc, size_t capacidade) {
+  if (!gc) {
+    return NULL; // Erro: coletor nulo
+  }
+
+  gc_regiao_t *regiao = (gc_regiao_t *)malloc(sizeof(gc_regiao_t));
+  if (!regiao) {
+    return NULL; // Erro: falha na alocacao
+  }
+
+  regiao->gc = gc;
+  regiao->blocos = NULL;
+  regiao->num_escapes = 0;
+  regiao->num_referencias = 0;
+  regiao->num_registos = 0;
+
+  if (!gc_regiao_novo_bloco(regiao, capacidade)) {
+    free(regiao);
+    return NULL; // Erro: falha na alocacao
+  }
+
+  // Adicionar a lista de regioes ativas
+  regiao->proxima = gc->regioes;
+  gc->regioes = regiao;
+
+  return regiao;
+}
+
+/**
+ * @brief Aloca memoria numa regiao, por incremento.
+ *
+ * @param regiao Apontador para a regiao.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @return Apontador para a memoria alocada, ou NULL em caso de falha.
+ */
+void *gc_regiao_alocar(gc_regiao_t *regiao, size_t tamanho) {
+  if (!regiao || tamanho == 0) {
+    return NULL; // Erro: regiao nula ou tamanho invalido
+  }
+
+  size_t necessario = GC_REGIAO_CABECALHO_OBJETO + GC_ALINHAR(tamanho);
+  if (necessario < tamanho) {
+    return NULL; // Erro: overflow no tamanho
+  }
+
+  gc_regiao_bloco_t *bloco = regiao->blocos;
+  if (bloco->capacidade - bloco->usado < necessario) {
+    bloco = gc_regiao_novo_bloco(regiao, necessario);
+    if (!bloco) {
+      return NULL; // Erro: falha na alocacao
+    }
+  }
+
+  gc_regiao_objeto_t *cabecalho =
+      (gc_regiao_objeto_t *)(gc_regiao_bloco_dados(bloco) + bloco->usado);
+  cabecalho->tamanho = tamanho;
+  cabecalho->escapou = false;
+  cabecalho->destino = NULL;
+  bloco->usado += necessario;
+
+  return (char *)cabecalho + GC_REGIAO_CABECALHO_OBJETO;
+}
+
+/**
+ * @brief Encontra a regiao ativa que contem um apontador.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param ptr Apontador para os dados de um objeto.
+ * @return Apontador para a regiao, ou NULL se nao pertence a nenhuma.
+ */
+gc_regiao_t *gc_encontrar_regiao(gc_t *gc, void *ptr) {
+  if (!gc || !ptr) {
+    return NULL; // Erro: coletor nulo ou apontador nulo
+  }
+
+  for (gc_regiao_t *regiao = gc->regioes; regiao; regiao = regiao->proxima) {
+    if (gc_regiao_contem(regiao, ptr)) {
+      return regiao;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Atualiza a contabilidade das regioes ao registar uma referencia.
+ *
+ * Um objeto de uma regiao referenciado de fora dela (do heap ou de outra
+ * regiao) e marcado como tendo escapado, para ser promovido no fim.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param de Apontador para o objeto de origem.
+ * @param para Apontador para o objeto de destino.
+ */
+void gc_regiao_registar_referencia(gc_t *gc, void *de, void *para) {
+  if (!gc || !gc->regioes) {
+    return; // Sem regioes ativas
+  }
+
+  gc_regiao_t *regiao_de = gc_encontrar_regiao(gc, de);
+  gc_regiao_t *regiao_para = gc_encontrar_regiao(gc, para);
+
+  if (regiao_para) {
+    regiao_para->num_referencias++;
+    gc_regiao_objeto_t *cabecalho = gc_regiao_cabecalho(para);
+    if (regiao_de != regiao_para && !cabecalho->escapou) {
+      cabecalho->escapou = true;
+      regiao_para->num_escapes++;
+    }
+  }
+
+  if (regiao_de && regiao_de != regiao_para) {
+    regiao_de->num_referencias++;
+  }
+}
+
+/**
+ * @brief Conta uma raiz, campo fraco ou efémero na regiao de um apontador.
+ *
+ * O fim da regiao so percorre as raizes, os campos fracos e os efémeros
+ * do coletor se alguma destas estruturas foi registada com um dos seus
+ * objetos.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param ptr Apontador registado.
+ */
+void gc_regiao_registar(gc_t *gc, void *ptr) {
+  if (!gc || !gc->regioes) {
+    return; // Sem regioes ativas
+  }
+
+  gc_regiao_t *regiao = gc_encontrar_regiao(gc, ptr);
+  if (regiao) {
+    regiao->num_registos++;
+  }
+}
+
+/**
+ * @brief Devolve o tamanho de um objeto, do heap ou de uma regiao.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param ptr Apontador para os dados do objeto.
+ * @return Tamanho do objeto em bytes, ou 0 se nao for encontrado.
+ */
+static size_t gc_regiao_tamanho_objeto(gc_t *gc, void *ptr) {
+  if (gc_encontrar_regiao(gc, ptr)) {
+    return gc_regiao_cabecalho(ptr)->tamanho;
+  }
+
+  gc_object_t *obj = gc_encontrar_objeto(gc, ptr);
+  return obj ? obj->tamanho : 0;
+}
+
+/**
+ * @brief Substitui, nos dados de um objeto, um apontador por outro.
+ *
+ * @param objeto Apontador para os dados do objeto.
+ * @param tamanho Tamanho do objeto em bytes.
+ * @param antigo Valor a procurar.
+ * @param novo Valor a escrever.
+ */
+static void gc_regiao_corrigir_campos(void *objeto, size_t tamanho,
+                                      void *antigo, void *novo) {
+  void **campos = (void **)objeto;
+  for (size_t i = 0; i < tamanho / sizeof(void *); i++) {
+    if (campos[i] == antigo) {
+      campos[i] = novo;
+    }
+  }
+}
+
+/**
+ * @brief Promove para o heap os objetos de uma regiao que escaparam.
+ *
+ * O conjunto de objetos a promover e fechado transitivamente pelas
+ * referencias dentro da regiao. As referencias registadas, as raizes e
+ * os campos dos objetos de origem passam a apontar para as copias.
+ *
+ * Se a copia de algum objeto falhar, as copias ja feitas sao libertadas
+ * e nada e alterado: uma promoçao parcial deixaria campos de objetos do
+ * heap a apontar para memoria da regiao.
+ *
+ * @param regiao Apontador para a regiao.
+ * @return true em caso de sucesso, false se faltar memoria para as copias.
+ */
+static bool gc_regiao_promover(gc_regiao_t *regiao) {
+  gc_t *gc = regiao->gc;
+
+  // Fecho transitivo: o que e alcançavel a partir de um objeto promovido
+  // tambem tem de ser promovido
+  bool alterado = true;
+  while (alterado) {
+    alterado = false;
+    for (size_t i = 0; i < gc->num_referencias; i++) {
+      void *de = gc_descomprimir(gc->referencias[i].de);
+      void *para = gc_descomprimir(gc->referencias[i].para);
+      if (gc_regiao_contem(regiao, de) && gc_regiao_contem(regiao, para) &&
+          gc_regiao_cabecalho(de)->escapou &&
+          !gc_regiao_cabecalho(para)->escapou) {
+        gc_regiao_cabecalho(para)->escapou = true;
+        alterado = true;
+      }
+    }
+  }
+
+  // Copiar os objetos promovidos para o heap. Usa-se gc_alocar_objeto
+  // para que uma coleta nao liberte copias ainda sem referencias.
+  size_t num_copias = 0;
+  bool falhou = false;
+  for (gc_regiao_bloco_t *bloco = regiao->blocos; bloco && !falhou;
+       bloco = bloco->proximo) {
+    char *atual = gc_regiao_bloco_dados(bloco);
+    char *fim = atual + bloco->usado;
+    while (atual < fim) {
+      gc_regiao_objeto_t *cabecalho = (gc_regiao_objeto_t *)atual;
+      void *dados = atual + GC_REGIAO_CABECALHO_OBJETO;
+      if (cabecalho->escapou) {
+        cabecalho->destino =
+            gc_alocar_objeto(gc, cabecalho->tamanho, NULL);
+        if (!cabecalho->destino) {
+          falhou = true;
+          break;
+        }
+        memcpy(cabecalho->destino, dados, cabecalho->tamanho);
+        num_copias++;
+      }
+      atual += GC_REGIAO_CABECALHO_OBJETO + GC_ALINHAR(cabecalho->tamanho);
+    }
+  }
+
+  if (falhou) {
+    // Desfazer: as copias sao os primeiros objetos da lista do coletor
+    while (num_copias-- > 0) {
+      gc_object_t *copia = gc->objetos;
+      gc->objetos = GC_PROXIMO(copia);
+      gc_libertar_objeto(gc, copia);
+    }
+    for (gc_regiao_bloco_t *bloco = regiao->blocos; bloco;
+         bloco = bloco->proximo) {
+      char *atual = gc_regiao_bloco_dados(bloco);
+      char *fim = atual + bloco->usado;
+      while (atual < fim) {
+        gc_regiao_objeto_t *cabecalho = (gc_regiao_objeto_t *)atual;
+        cabecalho->destino = NULL;
+        atual += GC_REGIAO_CABECALHO_OBJETO + GC_ALINHAR(cabecalho->tamanho);
+      }
+    }
+    return false; // Erro: falha na alocacao
+  }
+
+  // Redirecionar referencias e corrigir os campos dos objetos de origem
+  for (size_t i = 0; i < gc->num_referencias; i++) {
+    void *de = gc_descomprimir(gc->referencias[i].de);
+    void *para = gc_descomprimir(gc->referencias[i].para);
+
+    if (gc_regiao_contem(regiao, de)) {
+      if (!gc_regiao_cabecalho(de)->destino) {
+        continue; // Origem morre com a regiao
+      }
+      de = gc_regiao_cabecalho(de)->destino;
+    }
+
+    if (gc_regiao_contem(regiao, para)) {
+      void *destino = gc_regiao_cabecalho(para)->destino;
+      if (!destino) {
+        continue; // Destino nao promovido: origem tambem na regiao
+      }
+      gc_regiao_corrigir_campos(de, gc_regiao_tamanho_objeto(gc, de), para,
+                                destino);
+      para = destino;
+    }
+
+    gc->referencias[i].de = gc_comprimir(de);
+    gc->referencias[i].para = gc_comprimir(para);
+  }
+
+  // Raizes, referencias fracas e efémeros seguem as copias
+  for (size_t i = 0; regiao->num_registos > 0 && i < gc->num_raizes; i++) {
+    if (gc_regiao_contem(regiao, gc->raizes[i]) &&
+        gc_regiao_cabecalho(gc->raizes[i])->destino) {
+      gc->raizes[i] = gc_regiao_cabecalho(gc->raizes[i])->destino;
+    }
+  }
+  for (gc_regiao_bloco_t *bloco = regiao->blocos; bloco;
+       bloco = bloco->proximo) {
+    char *atual = gc_regiao_bloco_dados(bloco);
+    char *fim = atual + bloco->usado;
+    while (atual < fim) {
+      gc_regiao_objeto_t *cabecalho = (gc_regiao_objeto_t *)atual;
+      if (cabecalho->destino) {
+        gc_atualizar_fracas(gc, atual + GC_REGIAO_CABECALHO_OBJETO,
+                            cabecalho->destino, cabecalho->tamanho);
+      }
+      atual += GC_REGIAO_CABECALHO_OBJETO + GC_ALINHAR(cabecalho->tamanho);
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief Remove todos os registos do coletor que apontam para a regiao.
+ *
+ * @param regiao Apontador para a regiao.
+ */
+static void gc_regiao_limpar_registos(gc_regiao_t *regiao) {
+  gc_t *gc = regiao->gc;
+
+  // Referencias (so se alguma foi registada com objetos da regiao)
+  if (regiao->num_referencias > 0) {
+    size_t i = 0;
+    while (i < gc->num_referencias) {
+      if (gc_regiao_contem(regiao, gc_descomprimir(gc->referencias[i].de)) ||
+          gc_regiao_contem(regiao, gc_descomprimir(gc->referencias[i].para))) {
+        gc->referencias[i] = gc->referencias[--gc->num_referencias];
+      } else {
+        i++;
+      }
+    }
+  }
+
+  // Os campos fracos podem ter sido escritos com objetos da regiao depois
+  // de registados, por isso os valores sao sempre verificados
+  size_t i = 0;
+  while (i < gc->num_fracas) {
+    if (regiao->num_registos > 0 && gc_regiao_contem(regiao, gc->fracas[i])) {
+      gc->fracas[i] = gc->fracas[--gc->num_fracas];
+      continue;
+    }
+    if (gc_regiao_contem(regiao, *gc->fracas[i])) {
+      *gc->fracas[i] = NULL;
+    }
+    i++;
+  }
+
+  if (regiao->num_registos == 0) {
+    return; // Nenhuma raiz nem efémero com objetos da regiao
+  }
+
+  // Raizes
+  i = 0;
+  while (i < gc->num_raizes) {
+    if (gc_regiao_contem(regiao, gc->raizes[i])) {
+      gc->raizes[i] = gc->raizes[--gc->num_raizes];
+    } else {
+      i++;
+    }
+  }
+
+  // Efémeros
+  i = 0;
+  while (i < gc->num_efemeros) {
+    if (gc_regiao_contem(regiao, gc->efemeros[i].chave) ||
+        gc_regiao_contem(regiao, gc->efemeros[i].valor)) {
+      gc->efemeros[i] = gc->efemeros[--gc->num_efemeros];
+    } else {
+      i++;
+    }
+  }
+}
+
+/**
+ * @brief Termina uma regiao e liberta toda a sua memoria.
+ *
+ * Sem objetos que escaparam e sem referencias, raizes ou efémeros
+ * registados com objetos da regiao, o custo e o de libertar os blocos
+ * mais uma passagem pelos campos fracos registados no coletor.
+ *
+ * @param regiao Apontador para a regiao a terminar.
+ * @return Numero de bytes libertados, ou GC_REGIAO_FALHA se a promoçao
+ * falhou (a regiao continua ativa).
+ */
+size_t gc_regiao_fim(gc_regiao_t *regiao) {
+  if (!regiao) {
+    return 0; // Erro: regiao nula
+  }
+
+  gc_t *gc = regiao->gc;
+
+  if (regiao->num_escapes > 0 && !gc_regiao_promover(regiao)) {
+    return GC_REGIAO_FALHA; // Erro: sem memoria para promover os objetos
+  }
+  gc_regiao_limpar_registos(regiao);
+
+  // As referencias retiradas nao foram decrementadas e os objetos
+  // promovidos recebem referencias que nao foram contadas
+  if (regiao->num_referencias > 0 && gc->contagem_ativa) {
+    gc_contagem_recalcular(gc);
+  }
+
+  // Retirar da lista de regioes ativas
+  gc_regiao_t **atual = &gc->regioes;
+  while (*atual && *atual != regiao) {
+    atual = &(*atual)->proxima;
+  }
+  if (*atual) {
+    *atual = regiao->proxima;
+  }
+
+  // Libertar os blocos
+  size_t bytes_libertados = 0;
+  gc_regiao_bloco_t *bloco = regiao->blocos;
+  while (bloco) {
+    gc_regiao_bloco_t *proximo = bloco->proximo;
+    bytes_libertados += bloco->usado;
+    gc_regiao_libertar_bloco(bloco);
+    bloco = proximo;
+  }
+  free(regiao);
+
+  return bytes_libertados;
+}
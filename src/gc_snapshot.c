@@ -0,0 +1,272 @@
+/**
+ * @file gc_snapshot.c
+ * @brief Exportaçao do grafo de objetos do coletor de lixo.
+ *
+ * Este arquivo contem as funçoes que escrevem um snapshot binario
+ * do heap: todos os objetos com o seu tamanho, as raizes e as
+ * referencias entre objetos. O ficheiro resultante pode ser analisado
+ * offline pela ferramenta gc_analisar.
+ *
+ * As raizes e arestas sao as que a marcaçao segue: alem das raizes e
+ * referencias registadas, os objetos referenciados a partir de regioes
+ * e os que esperam pelo finalizador contam como raizes, e os campos
+ * visitados pelas funçoes de marcaçao dos tipos e os efémeros (chave
+ * para valor) contam como arestas.
+ *
+ * Formato do ficheiro (inteiros na ordem de bytes da maquina):
+ *   - cabecalho gc_snapshot_cabecalho_t;
+ *   - num_objetos entradas gc_snapshot_objeto_t (o indice e o id);
+ *   - num_raizes ids de 32 bits;
+ *   - num_referencias pares de ids de 32 bits (de, para).
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#include "gc.h"
+#include "gc_formato.h"
+#include "gc_interno.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Par endereço/id usado para traduzir apontadores em ids.
+ *
+ * @param endereco Apontador para os dados do objeto.
+ * @param id Indice do objeto no snapshot.
+ */
+typedef struct GCSnapshotEntrada {
+  uintptr_t endereco;
+  uint32_t id;
+} gc_snapshot_entrada_t;
+
+/**
+ * @brief Compara duas entradas pelo endereço (para qsort/bsearch).
+ */
+static int gc_snapshot_comparar(const void *a, const void *b) {
+  uintptr_t ea = ((const gc_snapshot_entrada_t *)a)->endereco;
+  uintptr_t eb = ((const gc_snapshot_entrada_t *)b)->endereco;
+  return (ea > eb) - (ea < eb);
+}
+
+/**
+ * @brief Procura o id de um objeto a partir do apontador para os dados.
+ *
+ * @param indice Array de entradas ordenado por endereço.
+ * @param num_objetos Numero de entradas no array.
+ * @param dados Apontador para os dados do objeto.
+ * @param id Apontador onde sera guardado o id encontrado.
+ * @return true se o apontador corresponde a um objeto, false caso contrario.
+ */
+static bool gc_snapshot_procurar(const gc_snapshot_entrada_t *indice,
+                                 size_t num_objetos, void *dados,
+                                 uint32_t *id) {
+  if (!indice) {
+    return false; // Heap vazio
+  }
+
+  gc_snapshot_entrada_t chave = {(uintptr_t)dados, 0};
+  const gc_snapshot_entrada_t *entrada = bsearch(
+      &chave, indice, num_objetos, sizeof(*indice), gc_snapshot_comparar);
+  if (!entrada) {
+    return false;
+  }
+  *id = entrada->id;
+  return true;
+}
+
+/**
+ * @brief Estado da escrita de raizes e arestas.
+ *
+ * @param ficheiro Ficheiro do snapshot.
+ * @param indice Indice endereço -> id, ordenado por endereço.
+ * @param num_objetos Numero de entradas no indice.
+ * @param de Id do objeto cujos campos estao a ser visitados.
+ * @param num_escritas Numero de raizes ou arestas escritas.
+ * @param erro Indica se ocorreu algum erro de escrita.
+ */
+typedef struct GCSnapshotEscrita {
+  FILE *ficheiro;
+  const gc_snapshot_entrada_t *indice;
+  size_t num_objetos;
+  uint32_t de;
+  uint64_t num_escritas;
+  int erro;
+} gc_snapshot_escrita_t;
+
+/**
+ * @brief Escreve uma raiz, se o apontador corresponder a um objeto.
+ *
+ * @param escrita Estado da escrita.
+ * @param dados Apontador para os dados do objeto.
+ */
+static void gc_snapshot_raiz(gc_snapshot_escrita_t *escrita, void *dados) {
+  uint32_t raiz;
+  if (!escrita->erro && gc_snapshot_procurar(escrita->indice,
+                                             escrita->num_objetos, dados,
+                                             &raiz)) {
+    escrita->erro = fwrite(&raiz, sizeof(raiz), 1, escrita->ficheiro) != 1;
+    escrita->num_escritas++;
+  }
+}
+
+/**
+ * @brief Escreve uma aresta, se ambos os apontadores forem objetos.
+ *
+ * @param escrita Estado da escrita.
+ * @param de Apontador para os dados do objeto de origem.
+ * @param para Apontador para os dados do objeto de destino.
+ */
+static void gc_snapshot_aresta(gc_snapshot_escrita_t *escrita, void *de,
+                               void *para) {
+  uint32_t aresta[2];
+  if (!escrita->erro &&
+      gc_snapshot_procurar(escrita->indice, escrita->num_objetos, de,
+                           &aresta[0]) &&
+      gc_snapshot_procurar(escrita->indice, escrita->num_objetos, para,
+                           &aresta[1])) {
+    escrita->erro = fwrite(aresta, sizeof(aresta), 1, escrita->ficheiro) != 1;
+    escrita->num_escritas++;
+  }
+}
+
+/**
+ * @brief Recebe os campos visitados pela funçao de marcaçao de um tipo.
+ *
+ * @param contexto Estado da escrita (gc_snapshot_escrita_t).
+ * @param objeto Apontador para o objeto referenciado.
+ */
+static void gc_snapshot_visitar(void *contexto, void *objeto) {
+  gc_snapshot_escrita_t *escrita = (gc_snapshot_escrita_t *)contexto;
+  uint32_t para;
+  if (!escrita->erro && gc_snapshot_procurar(escrita->indice,
+                                             escrita->num_objetos, objeto,
+                                             &para)) {
+    uint32_t aresta[2] = {escrita->de, para};
+    escrita->erro = fwrite(aresta, sizeof(aresta), 1, escrita->ficheiro) != 1;
+    escrita->num_escritas++;
+  }
+}
+
+/**
+ * @brief Escreve um snapshot binario do grafo de objetos.
+ *
+ * Raizes e referencias que nao correspondem a objetos geridos sao
+ * ignoradas. Os contadores de raizes e referencias no cabecalho sao
+ * reescritos no fim com o numero de entradas efetivamente escritas.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param caminho Caminho do ficheiro a criar.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_snapshot(gc_t *gc, const char *caminho) {
+  if (!gc || !caminho) {
+    return -1; // Erro: coletor nulo ou caminho nulo
+  }
+
+  // Contar objetos
+  size_t num_objetos = 0;
+  for (gc_object_t *obj = gc->objetos; obj; obj = GC_PROXIMO(obj)) {
+    num_objetos++;
+  }
+  if (num_objetos > UINT32_MAX) {
+    return -2; // Erro: demasiados objetos para ids de 32 bits
+  }
+
+  // Construir o indice endereço -> id
+  gc_snapshot_entrada_t *indice = NULL;
+  if (num_objetos > 0) {
+    indice = (gc_snapshot_entrada_t *)malloc(num_objetos * sizeof(*indice));
+    if (!indice) {
+      return -3; // Erro: falha na alocacao
+    }
+  }
+
+  FILE *ficheiro = fopen(caminho, "wb");
+  if (!ficheiro) {
+    free(indice);
+    return -4; // Erro: nao foi possivel criar o ficheiro
+  }
+
+  gc_snapshot_cabecalho_t cabecalho = {GC_SNAPSHOT_MAGIA, GC_SNAPSHOT_VERSAO,
+                                       num_objetos, 0, 0};
+  int erro = fwrite(&cabecalho, sizeof(cabecalho), 1, ficheiro) != 1;
+
+  // Escrever os objetos pela ordem da lista
+  uint32_t id = 0;
+  for (gc_object_t *obj = gc->objetos; obj && !erro; obj = GC_PROXIMO(obj)) {
+    gc_snapshot_objeto_t registo = {(uint64_t)(uintptr_t)GC_DADOS(obj),
+                                    (uint64_t)obj->tamanho};
+    erro = fwrite(&registo, sizeof(registo), 1, ficheiro) != 1;
+    indice[id].endereco = (uintptr_t)GC_DADOS(obj);
+    indice[id].id = id;
+    id++;
+  }
+  if (num_objetos > 0) {
+    qsort(indice, num_objetos, sizeof(*indice), gc_snapshot_comparar);
+  }
+
+  gc_snapshot_escrita_t escrita = {ficheiro, indice, num_objetos, 0, 0, erro};
+
+  // Escrever as raizes: registadas, referenciadas a partir de regioes e
+  // objetos a espera do finalizador
+  for (size_t i = 0; i < gc->num_raizes; i++) {
+    gc_snapshot_raiz(&escrita, gc->raizes[i]);
+  }
+  for (size_t i = 0; gc->regioes && i < gc->num_referencias; i++) {
+    if (gc_encontrar_regiao(gc, gc_descomprimir(gc->referencias[i].de))) {
+      gc_snapshot_raiz(&escrita, gc_descomprimir(gc->referencias[i].para));
+    }
+  }
+  pthread_mutex_lock(&gc->trinco_finalizar);
+  for (size_t i = 0; i < gc->num_fila; i++) {
+    gc_snapshot_raiz(&escrita, GC_DADOS(gc->fila[i].obj));
+  }
+  for (size_t i = 0; i < gc->num_em_execucao; i++) {
+    gc_snapshot_raiz(&escrita, GC_DADOS(gc->em_execucao[i].obj));
+  }
+  pthread_mutex_unlock(&gc->trinco_finalizar);
+  cabecalho.num_raizes = escrita.num_escritas;
+
+  // Escrever as referencias registadas e os efémeros
+  escrita.num_escritas = 0;
+  for (size_t i = 0; i < gc->num_referencias; i++) {
+    gc_snapshot_aresta(&escrita, gc_descomprimir(gc->referencias[i].de),
+                       gc_descomprimir(gc->referencias[i].para));
+  }
+  for (size_t i = 0; i < gc->num_efemeros; i++) {
+    gc_snapshot_aresta(&escrita, gc->efemeros[i].chave,
+                       gc->efemeros[i].valor);
+  }
+
+  // Escrever os campos visitados pelas funçoes de marcaçao dos tipos
+  if (gc->num_tipados > 0) {
+    gc->visitante = gc_snapshot_visitar;
+    gc->visitante_contexto = &escrita;
+    for (gc_object_t *obj = gc->objetos; obj && !escrita.erro;
+         obj = GC_PROXIMO(obj)) {
+      if (obj->tipo != 0) {
+        gc_snapshot_procurar(indice, num_objetos, GC_DADOS(obj),
+                             &escrita.de);
+        gc_tracar_objeto(gc, obj);
+      }
+    }
+    gc->visitante = NULL;
+    gc->visitante_contexto = NULL;
+  }
+  cabecalho.num_referencias = escrita.num_escritas;
+  erro = escrita.erro;
+
+  // Reescrever o cabecalho com os contadores finais
+  if (!erro) {
+    erro = fseek(ficheiro, 0, SEEK_SET) != 0 ||
+           fwrite(&cabecalho, sizeof(cabecalho), 1, ficheiro) != 1;
+  }
+
+  erro |= fclose(ficheiro) != 0;
+  free(indice);
+
+  return erro ? -5 : 0; // Erro: falha na escrita
+}
@@ -0,0 +1,191 @@
+/**
+ * @file gc_strings.c
+ * @brief Implementaçao da tabela de strings internadas.
+ *
+ * Este arquivo contem as funçoes que mantem uma unica copia gerida de
+ * cada string internada. A tabela usa endereçamento aberto com sondagem
+ * linear e guarda o hash de cada entrada, para que a comparaçao do
+ * conteudo so seja feita quando os hashes coincidem.
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#include "gc.h"
+#include "gc_interno.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Calcula o hash FNV-1a de uma string e o seu comprimento.
+ *
+ * @param str String terminada em nulo.
+ * @param comprimento Apontador onde sera guardado o comprimento.
+ * @return Hash da string.
+ */
+static uint64_t gc_string_hash(const char *str, size_t *comprimento) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  const unsigned char *p = (const unsigned char *)str;
+  while (*p) {
+    hash ^= *p++;
+    hash *= 0x100000001b3ull;
+  }
+  *comprimento = (size_t)((const char *)p - str);
+  return hash;
+}
+
+/**
+ * @brief Procura a posiçao de uma string na tabela.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param hash Hash da string.
+ * @param str String a procurar.
+ * @param comprimento Comprimento da string.
+ * @return Indice da entrada com a string, ou da entrada livre onde
+ * deveria ser inserida.
+ */
+static size_t gc_string_posicao(gc_t *gc, uint64_t hash, const char *str,
+                                size_t comprimento) {
+  size_t mascara = gc->cap_strings - 1;
+  size_t i = (size_t)hash & mascara;
+  while (gc->strings[i].dados) {
+    // O objeto guardado tem strlen + 1 bytes: comparar o tamanho primeiro
+    if (gc->strings[i].hash == hash &&
+        GC_OBJETO(gc->strings[i].dados)->tamanho == comprimento + 1 &&
+        memcmp(gc->strings[i].dados, str, comprimento + 1) == 0) {
+      break;
+    }
+    i = (i + 1) & mascara;
+  }
+  return i;
+}
+
+/**
+ * @brief Garante espaço para mais uma string, duplicando a tabela quando
+ * a ocupaçao passa de 50%.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+static int gc_string_crescer(gc_t *gc) {
+  if (2 * (gc->num_strings + 1) <= gc->cap_strings) {
+    return 0;
+  }
+
+  size_t capacidade = gc->cap_strings ? 2 * gc->cap_strings
+                                      : GC_STRINGS_CAPACIDADE_INICIAL;
+  gc_string_t *nova = (gc_string_t *)calloc(capacidade, sizeof(gc_string_t));
+  if (!nova) {
+    return -1; // Erro: falha na alocacao
+  }
+
+  for (size_t i = 0; i < gc->cap_strings; i++) {
+    if (gc->strings[i].dados) {
+      size_t j = (size_t)gc->strings[i].hash & (capacidade - 1);
+      while (nova[j].dados) {
+        j = (j + 1) & (capacidade - 1);
+      }
+      nova[j] = gc->strings[i];
+    }
+  }
+
+  free(gc->strings);
+  gc->strings = nova;
+  gc->cap_strings = capacidade;
+
+  return 0;
+}
+
+/**
+ * @brief Devolve a copia partilhada de uma string, criando-a se necessario.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param str String a internar.
+ * @return Apontador para a string internada, ou NULL em caso de falha.
+ */
+const char *gc_internar_string(gc_t *gc, const char *str) {
+  if (!gc || !str) {
+    return NULL; // Erro: coletor nulo ou string nula
+  }
+
+  size_t comprimento;
+  uint64_t hash = gc_string_hash(str, &comprimento);
+
+  if (gc->num_strings > 0) {
+    size_t i = gc_string_posicao(gc, hash, str, comprimento);
+    if (gc->strings[i].dados) {
+      return gc->strings[i].dados; // Ja internada
+    }
+  }
+
+  // Nova copia; a alocaçao pode coletar e retirar entradas da tabela,
+  // por isso a posiçao so e calculada depois
+  char *nova_str = (char *)gc_alocar(gc, comprimento + 1);
+  if (!nova_str) {
+    return NULL; // Erro: falha na alocacao
+  }
+  memcpy(nova_str, str, comprimento + 1);
+
+  if (gc_string_crescer(gc) != 0) {
+    return nova_str; // Sem tabela: devolve uma copia nao partilhada
+  }
+
+  size_t i = gc_string_posicao(gc, hash, nova_str, comprimento);
+  gc->strings[i].hash = hash;
+  gc->strings[i].dados = nova_str;
+  gc->num_strings++;
+  GC_OBJETO(nova_str)->bandeiras |= GC_BANDEIRA_INTERNADA;
+
+  return nova_str;
+}
+
+/**
+ * @brief Retira da tabela de strings internadas um objeto libertado.
+ *
+ * As entradas seguintes do mesmo grupo sao recuadas, para que a sondagem
+ * linear continue a encontra-las sem marcas de entradas apagadas.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto (com GC_BANDEIRA_INTERNADA).
+ */
+void gc_remover_string(gc_t *gc, gc_object_t *obj) {
+  if (!gc || !obj || gc->num_strings == 0) {
+    return; // Erro: coletor nulo ou tabela vazia
+  }
+
+  char *dados = (char *)GC_DADOS(obj);
+  size_t comprimento;
+  uint64_t hash = gc_string_hash(dados, &comprimento);
+  size_t mascara = gc->cap_strings - 1;
+
+  size_t i = (size_t)hash & mascara;
+  while (gc->strings[i].dados != dados) {
+    if (!gc->strings[i].dados) {
+      // O conteudo foi alterado depois de internado: procurar pelo endereço
+      for (i = 0; i < gc->cap_strings && gc->strings[i].dados != dados; i++) {
+      }
+      if (i == gc->cap_strings) {
+        return; // Nao encontrada
+      }
+      break;
+    }
+    i = (i + 1) & mascara;
+  }
+
+  // Recuar as entradas seguintes que deixariam de ser alcançaveis
+  size_t j = i;
+  for (;;) {
+    j = (j + 1) & mascara;
+    if (!gc->strings[j].dados) {
+      break;
+    }
+    size_t ideal = (size_t)gc->strings[j].hash & mascara;
+    if (((j - ideal) & mascara) >= ((j - i) & mascara)) {
+      gc->strings[i] = gc->strings[j];
+      i = j;
+    }
+  }
+  gc->strings[i].dados = NULL;
+  gc->num_strings--;
+}
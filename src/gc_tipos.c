@@ -0,0 +1,100 @@
+/**
+ * @file gc_tipos.c
+ * @brief Implementaçao dos tipos de objeto com funçao de marcaçao.
+ *
+ * Este arquivo contem o registo de tipos do processo. Um objeto alocado
+ * com um tipo guarda o identificador no cabeçalho; durante a marcaçao a
+ * funçao do tipo visita os campos do objeto, em vez de o coletor procurar
+ * as suas ligaçoes no array de referencias.
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#include "gc.h"
+#include "gc_interno.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+/**
+ * @brief Funçoes de marcaçao dos tipos registados (o indice 0 nao e usado).
+ */
+static gc_tracador_t gc_tracadores[GC_MAX_TIPOS];
+static size_t gc_num_tipos = 1;
+static pthread_mutex_t gc_tipos_trinco = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Regista um tipo de objeto com a sua funçao de marcaçao.
+ *
+ * @param tracador Funçao de marcaçao dos objetos do tipo.
+ * @return Identificador do tipo (positivo), ou valor negativo em caso de erro.
+ */
+int gc_registar_tipo(gc_tracador_t tracador) {
+  if (!tracador) {
+    return -1; // Erro: funçao de marcaçao nula
+  }
+
+  pthread_mutex_lock(&gc_tipos_trinco);
+  if (gc_num_tipos >= GC_MAX_TIPOS) {
+    pthread_mutex_unlock(&gc_tipos_trinco);
+    return -2; // Erro: limite de tipos atingido
+  }
+  int tipo = (int)gc_num_tipos++;
+  gc_tracadores[tipo] = tracador;
+  pthread_mutex_unlock(&gc_tipos_trinco);
+
+  return tipo;
+}
+
+/**
+ * @brief Aloca um objeto de um tipo registado com gc_registar_tipo.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param tamanho Tamanho da memoria a ser alocada em bytes.
+ * @param tipo Identificador do tipo (0 para nenhum).
+ * @return Apontador para a memoria alocada, ou NULL em caso de falha.
+ */
+void *gc_alocar_tipo(gc_t *gc, size_t tamanho, int tipo) {
+  if (tipo < 0 || tipo >= GC_MAX_TIPOS) {
+    return NULL; // Erro: tipo invalido
+  }
+
+  void *dados = gc_alocar(gc, tamanho);
+  if (dados && tipo != 0) {
+    GC_OBJETO(dados)->tipo = (uint16_t)tipo;
+    gc->num_tipados++;
+  }
+
+  return dados;
+}
+
+/**
+ * @brief Marca um objeto referenciado a partir de uma funçao de marcaçao.
+ *
+ * Com um visitante ativo (durante o snapshot) o objeto e-lhe entregue em
+ * vez de ser marcado.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param objeto Apontador para o objeto referenciado, ou NULL.
+ */
+void gc_visitar(gc_t *gc, void *objeto) {
+  if (gc && gc->visitante) {
+    if (objeto) {
+      gc->visitante(gc->visitante_contexto, objeto);
+    }
+    return; // Percurso fora da marcaçao
+  }
+  gc_marcar(gc, objeto);
+}
+
+/**
+ * @brief Chama a funçao de marcaçao do tipo de um objeto, se tiver.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto.
+ */
+void gc_tracar_objeto(gc_t *gc, gc_object_t *obj) {
+  if (obj->tipo != 0 && gc_tracadores[obj->tipo]) {
+    gc_tracadores[obj->tipo](gc, GC_DADOS(obj));
+  }
+}
@@ -0,0 +1,217 @@
+/**
+ * @file gc_traco.c
+ * @brief Gravaçao de traços de alocaçao do coletor de lixo.
+ *
+ * Este arquivo contem as funçoes que registam, num ficheiro binario
+ * compacto, todas as chamadas a API que alteram o heap. O traço pode
+ * depois ser re-executado pela ferramenta gc_replay para comparar
+ * configuraçoes do coletor com cargas de trabalho reais.
+ *
+ * @author Joao Mendes
+ * @date Abril 2025
+ */
+
+#include "gc.h"
+#include "gc_formato.h"
+#include "gc_interno.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Codifica um inteiro sem sinal em LEB128.
+ *
+ * @param buffer Destino (pelo menos 10 bytes livres).
+ * @param valor Valor a codificar.
+ * @return Numero de bytes escritos.
+ */
+static size_t gc_traco_codificar(uint8_t *buffer, uint64_t valor) {
+  size_t n = 0;
+  do {
+    uint8_t byte = valor & 0x7f;
+    valor >>= 7;
+    buffer[n++] = byte | (valor ? 0x80 : 0);
+  } while (valor);
+  return n;
+}
+
+/**
+ * @brief Codifica um endereço como diferença zigzag para o anterior.
+ *
+ * @param gravador Gravador ativo.
+ * @param buffer Destino (pelo menos 10 bytes livres).
+ * @param endereco Endereço a codificar.
+ * @return Numero de bytes escritos.
+ */
+static size_t gc_traco_codificar_endereco(gc_gravador_t *gravador,
+                                          uint8_t *buffer, void *endereco) {
+  int64_t delta = (int64_t)((uintptr_t)endereco - gravador->ultimo_endereco);
+  gravador->ultimo_endereco = (uintptr_t)endereco;
+  uint64_t zigzag = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+  return gc_traco_codificar(buffer, zigzag);
+}
+
+/**
+ * @brief Grava um evento no traço de alocaçoes, se houver gravador ativo.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param evento Tipo do evento (gc_traco_evento_t).
+ * @param a Primeiro endereço do evento, ou NULL.
+ * @param b Segundo endereço do evento, ou NULL.
+ * @param tamanho Tamanho associado ao evento, ou 0.
+ */
+void gc_gravar_evento(gc_t *gc, int evento, void *a, void *b, size_t tamanho) {
+  if (!gc || !gc->gravador || gc->gravador->suspenso > 0) {
+    return; // Gravaçao inativa ou suspensa
+  }
+
+  gc_gravador_t *gravador = gc->gravador;
+  uint8_t buffer[32];
+  size_t n = 0;
+
+  buffer[n++] = (uint8_t)evento;
+  switch (evento) {
+  case GC_TRACO_ALOCAR:
+    n += gc_traco_codificar_endereco(gravador, buffer + n, a);
+    n += gc_traco_codificar(buffer + n, tamanho);
+    break;
+  case GC_TRACO_REALOCAR:
+    n += gc_traco_codificar_endereco(gravador, buffer + n, a);
+    n += gc_traco_codificar_endereco(gravador, buffer + n, b);
+    n += gc_traco_codificar(buffer + n, tamanho);
+    break;
+  case GC_TRACO_RAIZ:
+  case GC_TRACO_REMOVER_RAIZ:
+    n += gc_traco_codificar_endereco(gravador, buffer + n, a);
+    break;
+  case GC_TRACO_REFERENCIA:
+  case GC_TRACO_REMOVER_REFERENCIA:
+    n += gc_traco_codificar_endereco(gravador, buffer + n, a);
+    n += gc_traco_codificar_endereco(gravador, buffer + n, b);
+    break;
+  default:
+    break; // GC_TRACO_COLETAR nao tem argumentos
+  }
+
+  if (fwrite(buffer, 1, n, gravador->ficheiro) != n) {
+    gravador->erro = true;
+  }
+}
+
+/**
+ * @brief Suspende a gravaçao de eventos (chamadas internas do coletor).
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_gravar_suspender(gc_t *gc) {
+  if (gc && gc->gravador) {
+    gc->gravador->suspenso++;
+  }
+}
+
+/**
+ * @brief Retoma a gravaçao de eventos suspensa por gc_gravar_suspender.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ */
+void gc_gravar_retomar(gc_t *gc) {
+  if (gc && gc->gravador) {
+    gc->gravador->suspenso--;
+  }
+}
+
+/**
+ * @brief Inicia a gravaçao de um traço de alocaçoes.
+ *
+ * O estado atual do heap (objetos, raizes e referencias) e gravado
+ * primeiro, para que o traço possa ser re-executado de forma autonoma.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param caminho Caminho do ficheiro a criar.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_gravar_iniciar(gc_t *gc, const char *caminho) {
+  if (!gc || !caminho) {
+    return -1; // Erro: coletor nulo ou caminho nulo
+  }
+
+  if (gc->gravador) {
+    return -2; // Erro: gravaçao ja ativa
+  }
+
+  gc_gravador_t *gravador = (gc_gravador_t *)malloc(sizeof(gc_gravador_t));
+  if (!gravador) {
+    return -3; // Erro: falha na alocacao
+  }
+
+  gravador->ficheiro = fopen(caminho, "wb");
+  if (!gravador->ficheiro) {
+    free(gravador);
+    return -4; // Erro: nao foi possivel criar o ficheiro
+  }
+  gravador->ultimo_endereco = 0;
+  gravador->suspenso = 0;
+  gravador->erro = false;
+
+  gc_traco_cabecalho_t cabecalho = {GC_TRACO_MAGIA, GC_TRACO_VERSAO,
+                                    (uint64_t)gc->tamanho_heap};
+  if (fwrite(&cabecalho, sizeof(cabecalho), 1, gravador->ficheiro) != 1) {
+    gravador->erro = true;
+  }
+  gc->gravador = gravador;
+
+  // Gravar o estado atual: objetos pela ordem de alocaçao (a lista esta
+  // invertida, por isso percorre-se primeiro para um array auxiliar)
+  size_t num_objetos = 0;
+  for (gc_object_t *obj = gc->objetos; obj; obj = GC_PROXIMO(obj)) {
+    num_objetos++;
+  }
+  gc_object_t **ordem = NULL;
+  if (num_objetos > 0) {
+    ordem = (gc_object_t **)malloc(num_objetos * sizeof(gc_object_t *));
+  }
+  if (ordem) {
+    size_t i = num_objetos;
+    for (gc_object_t *obj = gc->objetos; obj; obj = GC_PROXIMO(obj)) {
+      ordem[--i] = obj;
+    }
+    for (i = 0; i < num_objetos; i++) {
+      gc_gravar_evento(gc, GC_TRACO_ALOCAR, GC_DADOS(ordem[i]), NULL,
+                       ordem[i]->tamanho);
+    }
+    free(ordem);
+  } else if (num_objetos > 0) {
+    gravador->erro = true;
+  }
+
+  for (size_t i = 0; i < gc->num_raizes; i++) {
+    gc_gravar_evento(gc, GC_TRACO_RAIZ, gc->raizes[i], NULL, 0);
+  }
+  for (size_t i = 0; i < gc->num_referencias; i++) {
+    gc_gravar_evento(gc, GC_TRACO_REFERENCIA,
+                     gc_descomprimir(gc->referencias[i].de),
+                     gc_descomprimir(gc->referencias[i].para), 0);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Termina a gravaçao do traço de alocaçoes e fecha o ficheiro.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @return 0 em caso de sucesso, valor negativo em caso de erro.
+ */
+int gc_gravar_parar(gc_t *gc) {
+  if (!gc || !gc->gravador) {
+    return -1; // Erro: coletor nulo ou gravaçao inativa
+  }
+
+  gc_gravador_t *gravador = gc->gravador;
+  bool erro = gravador->erro;
+  erro |= fclose(gravador->ficheiro) != 0;
+  free(gravador);
+  gc->gravador = NULL;
+
+  return erro ? -2 : 0; // Erro: falha na escrita
+}
@@ -25,9 +25,10 @@ void gc_remover_referencias(gc_t *gc, void *objeto) {
   }
 
   // Remove todas as referencias que envolvem o objeto
+  gc_ref_t ref = gc_comprimir(objeto);
   size_t i = 0;
   while (i < gc->num_referencias) {
-    if (gc->referencias[i].de == objeto || gc->referencias[i].para == objeto) {
+    if (gc->referencias[i].de == ref || gc->referencias[i].para == ref) {
       // Remove a referencia
       gc->referencias[i] = gc->referencias[gc->num_referencias - 1];
       // Diminui o numero de referencias
@@ -38,6 +39,45 @@ void gc_remover_referencias(gc_t *gc, void *objeto) {
   }
 }
 
+/**
+ * @brief Liberta um objeto ja retirado da lista de objetos.
+ *
+ * Remove as referencias, referencias fracas e entradas da tabela de
+ * strings que envolvem o objeto e devolve o seu slot as paginas.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @param obj Apontador para o cabeçalho do objeto.
+ */
+void gc_libertar_objeto(gc_t *gc, gc_object_t *obj) {
+  // Atualizar a memoria usada
+  gc->memoria_usada -= obj->tamanho;
+
+  // Remover referencias para este objeto
+  gc_remover_referencias(gc, GC_DADOS(obj));
+
+  // Limpar referencias fracas e efémeros deste objeto
+  gc_remover_fracas(gc, GC_DADOS(obj), obj->tamanho);
+
+  // Retirar a string da tabela de internamento
+  if (obj->bandeiras & GC_BANDEIRA_INTERNADA) {
+    gc_remover_string(gc, obj);
+  }
+
+  if (obj->tipo != 0) {
+    gc->num_tipados--;
+  }
+
+  // Libertado fora de uma coleta: o finalizador corre agora
+  if (obj->bandeiras & GC_BANDEIRA_FINALIZAVEL) {
+    gc_correr_finalizador(gc, obj);
+  }
+
+  // Libertar o slot do objeto (objetos de imagens ficam no mapeamento)
+  if (!(obj->bandeiras & GC_BANDEIRA_IMAGEM)) {
+    gc_paginas_libertar(gc, obj);
+  }
+}
+
 /**
  * @brief Varre o heap e liberta todos os objetos nao marcados.
  * 
@@ -52,32 +92,78 @@ size_t gc_varrer(gc_t *gc) {
     return 0; // Erro: coletor nulo
   }
 
+  // Os buffers da contagem podem apontar para objetos que vao ser libertados
+  gc_contagem_descartar(gc);
+
   size_t bytes_libertados = 0;
-  gc_object_t **atual = (&gc->objetos);
+  gc_object_t *anterior = NULL;
+  gc_object_t *atual = gc->objetos;
+
+  while (atual) {
+    gc_object_t *proximo = GC_PROXIMO(atual);
+
+    if (!gc_objeto_marcado(gc, atual)) {
+      // Retirar o objeto da lista
+      if (anterior) {
+        anterior->proximo = atual->proximo;
+      } else {
+        gc->objetos = proximo;
+      }
+
+      // Contar bytes libertados e libertar o objeto
+      bytes_libertados += atual->tamanho;
+      gc_libertar_objeto(gc, atual);
+    } else {
+      // Objeto marcado, avançar para o proximo
+      anterior = atual;
+    }
 
-  while (*atual) {
-    if ((*atual)->marcado == GC_OBJETO_NAO_MARCADO) {
-      // Objeto nao marcado, libertar memoria
-      gc_object_t *obj_nao_marcado = *atual;
+    atual = proximo;
+  }
 
-      // Atualiza o apontador para o proximo objeto
-      *atual = obj_nao_marcado->proximo;
+  // Devolver ao pool as paginas que ficaram vazias
+  gc_paginas_reorganizar(gc);
 
-      // Contar bytes libertados
-      bytes_libertados += obj_nao_marcado->tamanho;
-      gc->memoria_usada -= obj_nao_marcado->tamanho;
+  // Acertar as contagens com o grafo que sobreviveu
+  if (gc->contagem_ativa) {
+    gc_contagem_recalcular(gc);
+  }
 
-      // Remover referencias para este objeto
-      gc_remover_referencias(gc, obj_nao_marcado->dados);
+  return bytes_libertados;
+}
 
-      // Libertar memoria do objeto
-        free(obj_nao_marcado->dados);
-        free(obj_nao_marcado);
+/**
+ * @brief Liberta os objetos marcados como mortos pela contagem de referencias.
+ *
+ * @param gc Apontador para o coletor de lixo.
+ * @return Numero de bytes libertados.
+ */
+size_t gc_varrer_libertados(gc_t *gc) {
+  size_t bytes_libertados = 0;
+  gc_object_t *anterior = NULL;
+  gc_object_t *atual = gc->objetos;
+
+  while (atual) {
+    gc_object_t *proximo = GC_PROXIMO(atual);
+
+    if (atual->bandeiras & GC_BANDEIRA_LIBERTADA) {
+      if (anterior) {
+        anterior->proximo = atual->proximo;
+      } else {
+        gc->objetos = proximo;
+      }
+      bytes_libertados += atual->tamanho;
+      gc_libertar_objeto(gc, atual);
     } else {
-      // Objeto marcado, avançar para o proximo
-      atual = &((*atual)->proximo);
+      anterior = atual;
     }
+
+    atual = proximo;
+  }
+
+  if (bytes_libertados > 0) {
+    gc_paginas_reorganizar(gc);
   }
 
   return bytes_libertados;
-}
\ No newline at end of file
+}